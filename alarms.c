@@ -0,0 +1,71 @@
+#include "pico/stdlib.h"
+#include "journal.h"
+#include "alarms.h"
+
+static const char* const alarm_labels[ALARM_COUNT] = {
+#define ALARM_LABEL(alarm, label) [alarm] = label,
+	ALARM_LIST(ALARM_LABEL)
+#undef ALARM_LABEL
+};
+
+static uint32_t active_mask	 = 0; // alarms whose condition is present right now
+static uint32_t latched_mask = 0; // alarms raised since the last `alarms_clear()`
+
+/**
+ * @brief Updates the live state of an alarm.
+ *
+ * Raising an alarm also latches it, so a condition that came and went is still reported until the
+ * user acknowledges it. Each time the condition appears it is logged to the journal.
+ *
+ * @param alarm  The alarm to update.
+ * @param active true if the alarm condition is present.
+ */
+void alarms_set(alarms_id_t alarm, bool active)
+{
+	if(active)
+	{
+		if(!(active_mask & ALARM_BIT(alarm)))
+		{
+			journal_log(JOURNAL_ALARM, alarm);
+		}
+		active_mask	 |= ALARM_BIT(alarm);
+		latched_mask |= ALARM_BIT(alarm);
+	} else
+	{
+		active_mask &= ~ALARM_BIT(alarm);
+	}
+}
+
+/**
+ * @brief Returns the mask of alarms whose condition is present right now.
+ */
+uint32_t alarms_active()
+{
+	return active_mask;
+}
+
+/**
+ * @brief Returns the mask of alarms raised since the last `alarms_clear()`.
+ */
+uint32_t alarms_latched()
+{
+	return latched_mask;
+}
+
+/**
+ * @brief Acknowledges the latched alarms.
+ *
+ * Alarms whose condition is still present stay latched.
+ */
+void alarms_clear()
+{
+	latched_mask = active_mask;
+}
+
+/**
+ * @brief Returns the display label of an alarm.
+ */
+const char* alarms_label(alarms_id_t alarm)
+{
+	return alarm_labels[alarm];
+}
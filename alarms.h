@@ -0,0 +1,41 @@
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include "pico/stdlib.h"
+
+/**
+ * @brief Alarm conditions: X(alarm, label).
+ *
+ * The `alarms_id_t` enum and the label table are generated from this list.
+ */
+#define ALARM_LIST(X)                         \
+	X(ALARM_PUMP_OVERCURRENT, "PUMP CURRENT") \
+	X(ALARM_PUMP_NO_FLOW, "NO FLOW")          \
+	X(ALARM_PUMP_DRY_RUN, "DRY RUN")          \
+	X(ALARM_PUMP_STALL, "PUMP STALL")         \
+	X(ALARM_CHIP_OVERTEMP, "CHIP HOT")
+
+/**
+ * @enum alarms_id_t
+ * @brief Alarm conditions, see `ALARM_LIST`. Each alarm is one bit in the alarm masks.
+ */
+typedef enum
+{
+#define ALARM_ENUM(alarm, label) alarm,
+	ALARM_LIST(ALARM_ENUM)
+#undef ALARM_ENUM
+	ALARM_COUNT
+} alarms_id_t;
+
+/**
+ * @brief Converts an alarm to its bit in the alarm masks.
+ */
+#define ALARM_BIT(alarm) (1u << (alarm))
+
+extern void		   alarms_set(alarms_id_t alarm, bool active);
+extern uint32_t	   alarms_active();
+extern uint32_t	   alarms_latched();
+extern void		   alarms_clear();
+extern const char* alarms_label(alarms_id_t alarm);
+
+#endif // ALARMS_H
@@ -1,63 +1,53 @@
 #include <stdio.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
-#include "hardware/pwm.h"
 #include "pico/bootrom.h"
-#include <hardware/sync.h>
-#include <hardware/flash.h>
 #include "pins.h"
 #include "ssd1306.h"
+#include "power.h"
+#include "outputs.h"
+#include "timebase.h"
+#include "task.h"
+#include "alarms.h"
+#include "thermal.h"
+#include "sensors.h"
+#include "pump_monitor.h"
+#include "light.h"
+#include "solar.h"
+#include "profile.h"
+#include "storage.h"
+#include "ui_list.h"
+#include "journal.h"
 #include "app.h"
 
 static void app_reload_profiles(bool with_ui);
+static void app_redraw();
+static void app_draw_profile_row(int index, int x, int y);
+static void app_draw_period_row(int index, int x, int y);
+static void app_draw_journal_row(int index, int x, int y);
 
-#define PWM_WRAP		   25000 // 5kHz at 125MHz clock (125MHz / 25000 = 5kHz)
+#define OLED_I2C_BAUD	   400000 // OLED I2C bus speed, re-applied after every clock change
 
-#define MAX_PROFILES	   5 // 3 predefined + 2 custom
-#define MAX_PERIODS		   6 // up to 6 periods per profile
+#define UI_IDLE_TIMEOUT_MS 60000 // return to the state screen after this long without input
+#define IDLE_BLANK_DISPLAY 1	 // 1 to switch the OLED off while the UI is idle
+
+#define APP_MENU_ROWS	   4	 // menu rows that fit on the screen at scale 2
+#define APP_DIAG_ROWS	   8	 // diagnostics lines that fit on the screen at scale 1
+#define APP_PROFILE_ROWS   3	 // profile browser rows, the bottom of the screen shows the selected profile
+#define APP_PROFILE_ACCEL  8	 // profile browser step multiplier while the encoder turns fast
+#define APP_MESSAGE_MS	   2000	 // how long status messages (SAVED..., NO DATA) stay on screen
+#define APP_AUTOSAVE_MS	   10000 // edits are written to flash after this long without another edit
+#define APP_PREVIEW_MS	   100	 // LED previews while a level is edited reach the outputs at most this often
+
+#define SUN_DEFAULT_LATITUDE 45  // latitude of the predefined SUN profile, degrees north
+#define SUN_DEFAULT_DAY		 172 // day of year assumed at boot until set from the menu (June 21st)
 
 #define PUMP_RUN_MINUTES   5									  // run pump for 5 minutes when activated
 #define PUMP_WAIT_MINUTES  30									  // wait for 30 minutes before next activation
 #define PUMP_TOTAL_MINUTES (PUMP_RUN_MINUTES + PUMP_WAIT_MINUTES) // maximum minutes pump can run in a day
 
-/**
- * @struct period_t
- * @brief Represents a time period configuration for LED control.
- *
- * This structure defines the parameters for a specific period, including its duration
- * and the power levels for white/red and blue LEDs.
- *
- * @var period_t::duration
- *   Duration of the period in minutes. Set to 0 to disable this period.
- * @var period_t::led_white_red_power
- *   Power level for white and red LEDs (range: 0-100).
- * @var period_t::led_blue_power
- *   Power level for blue LED (range: 0-100).
- */
-typedef struct
-{
-	int duration;			 // minutes. 0 to disable period
-	int led_white_red_power; // white and red leds power 0-100
-	int led_blue_power;		 // blue led power 0-100
-} period_t;
-
-/**
- * @struct profile_t
- * @brief Represents a user profile containing a name and a set of periods.
- *
- * @var profile_t::name
- *   The profile name (null-terminated string, up to 15 characters plus null terminator).
- *
- * @var profile_t::periods
- *   Array of periods associated with the profile (maximum defined by MAX_PERIODS, typically up to 6).
- */
-typedef struct
-{
-	char	 name[16];			   // profile name
-	period_t periods[MAX_PERIODS]; // up to 6 periods per day
-} profile_t;
-
 /**
  * @struct app_state_t
  * @brief Represents the current state of the application, including LED power levels, pump state, and timing
@@ -86,64 +76,42 @@ typedef struct
 	int	 period_minutes_left; // Minutes left in the current period
 } app_state_t;
 
-static profile_t profiles[MAX_PROFILES] = {
+/**
+ * @brief Profiles the library is formatted with on first boot: 4 predefined + 2 custom.
+ */
+static const profile_t default_profiles[] = {
 	{.name = "VEG",
 	 .periods =
 		 {
-			 {.duration = 60 * 14, .led_white_red_power = 100, .led_blue_power = 100}, // 14 hours
-			 {.duration = 60 * 10, .led_white_red_power = 0, .led_blue_power = 0},	   // 10 hours
-			 {.duration = 0},														   // disabled
-			 {.duration = 0},														   // disabled
-			 {.duration = 0},														   // disabled
-			 {.duration = 0}														   // disabled
-		 }},
+			 PERIOD_PACK(60 * 14, 100, 100), // 14 hours
+			 PERIOD_PACK(60 * 10, 0, 0),	 // 10 hours
+		 }}, // remaining periods disabled
 	{.name = "FLOWER",
 	 .periods =
 		 {
-			 {.duration = 60 * 12, .led_white_red_power = 100, .led_blue_power = 0}, // 12 hours
-			 {.duration = 60 * 12, .led_white_red_power = 0, .led_blue_power = 0},	 // 12 hours
-			 {.duration = 0},														 // disabled
-			 {.duration = 0},														 // disabled
-			 {.duration = 0},														 // disabled
-			 {.duration = 0}														 // disabled
+			 PERIOD_PACK(60 * 12, 100, 0), // 12 hours
+			 PERIOD_PACK(60 * 12, 0, 0),   // 12 hours
 		 }},
 	{.name = "FRUIT",
 	 .periods =
 		 {
-			 {.duration = 60 * 16, .led_white_red_power = 100, .led_blue_power = 0}, // 16 hours
-			 {.duration = 60 * 8, .led_white_red_power = 0, .led_blue_power = 0},	 // 8 hours
-			 {.duration = 0},														 // disabled
-			 {.duration = 0},														 // disabled
-			 {.duration = 0},														 // disabled
-			 {.duration = 0}														 // disabled
+			 PERIOD_PACK(60 * 16, 100, 0), // 16 hours
+			 PERIOD_PACK(60 * 8, 0, 0),	   // 8 hours
 		 }},
-	{.name = "CUSTOM 1",
+	{.name	   = "SUN",
+	 .type	   = PROFILE_SUN,
+	 .latitude = SUN_DEFAULT_LATITUDE,
 	 .periods =
 		 {
-			 {.duration = 0}, // disabled
-			 {.duration = 0}, // disabled
-			 {.duration = 0}, // disabled
-			 {.duration = 0}, // disabled
-			 {.duration = 0}, // disabled
-			 {.duration = 0}  // disabled
+			 PERIOD_PACK(60 * 12, 100, 100), // sunrise to sunset
+			 PERIOD_PACK(60 * 12, 0, 0),	 // night
 		 }},
-	{.name	  = "CUSTOM 2",
-	 .periods = {
-		 {.duration = 0}, // disabled
-		 {.duration = 0}, // disabled
-		 {.duration = 0}, // disabled
-		 {.duration = 0}, // disabled
-		 {.duration = 0}, // disabled
-		 {.duration = 0}  // disabled
-	 }	  }
+	{.name = "CUSTOM 1"}, // all periods disabled
+	{.name = "CUSTOM 2"}, // all periods disabled
 };
 
 /**
- * @enum app_mode_t
- * @brief Represents the different operational modes of the application.
- *
- * Enumerates all possible modes the application can be in, such as displaying state,
- * editing profiles, adjusting levels, and navigating menus.
+ * @brief Application modes and their handlers: X(mode, on_encoder, on_click, draw).
  *
  * - MODE_SHOW_STATE:        Display the current state.
  * - MODE_SHOW_PROFILE:      Display the current profile.
@@ -154,93 +122,233 @@ static profile_t profiles[MAX_PROFILES] = {
  * - MODE_EDIT_DURATION:     Edit the duration settings.
  * - MODE_TOP_MENU:          Display the top menu.
  * - MODE_TIME_SHIFT:        Adjust the time shift.
+ * - MODE_SUN_DAY:           Set the day of year used by SUN profiles.
+ * - MODE_DIAG:              Show the diagnostics counters (flash wear, latencies), scrolled by the encoder.
+ * - MODE_JOURNAL:           Browse the event journal, newest event first.
+ * - MODE_MESSAGE:           Show a status message, input is ignored.
+ *
+ * The `app_mode_t` enum and the `app_modes[]` dispatch table are both generated from this list,
+ * so adding a screen takes one line here plus its handler functions.
+ */
+#define APP_MODES(X)                                                                                    \
+	X(MODE_SHOW_STATE, app_encoder_show_profile, app_click_show_state, app_draw_current_state)          \
+	X(MODE_SHOW_PROFILE, app_encoder_show_profile, app_click_show_profile, app_draw_profile)            \
+	X(MODE_EDIT_PROFILE, app_encoder_edit_profile, app_click_edit_profile, app_draw_edit_profile)       \
+	X(MODE_EDIT_PERIOD, app_encoder_edit_period, app_click_edit_period, app_draw_edit_period)           \
+	X(MODE_EDIT_WR_LEVEL, app_encoder_edit_white_red_level, app_click_edit_value, app_draw_edit_period) \
+	X(MODE_EDIT_BL_LEVEL, app_encoder_edit_blue_level, app_click_edit_value, app_draw_edit_period)      \
+	X(MODE_EDIT_DURATION, app_encoder_edit_duration, app_click_edit_value, app_draw_edit_period)        \
+	X(MODE_TOP_MENU, app_encoder_top_menu, app_click_top_menu, app_draw_top_menu)                       \
+	X(MODE_TIME_SHIFT, app_encoder_time_shift, app_click_time_shift, app_draw_time_shift)               \
+	X(MODE_SUN_DAY, app_encoder_sun_day, app_click_sun_day, app_draw_sun_day)                           \
+	X(MODE_DIAG, app_encoder_diag, app_click_diag, app_draw_diag)                                       \
+	X(MODE_JOURNAL, app_encoder_journal, app_click_journal, app_draw_journal)                           \
+	X(MODE_MESSAGE, app_encoder_ignore, app_click_ignore, app_draw_message)
+
+/**
+ * @enum app_mode_t
+ * @brief Represents the different operational modes of the application, see `APP_MODES`.
  */
 typedef enum
 {
-	MODE_SHOW_STATE,
-	MODE_SHOW_PROFILE,
-	MODE_EDIT_PROFILE,
-	MODE_EDIT_PERIOD,
-	MODE_EDIT_WR_LEVEL,
-	MODE_EDIT_BL_LEVEL,
-	MODE_EDIT_DURATION,
-	MODE_TOP_MENU,
-	MODE_TIME_SHIFT,
+#define APP_MODE_ENUM(mode, on_encoder, on_click, draw) mode,
+	APP_MODES(APP_MODE_ENUM)
+#undef APP_MODE_ENUM
+	MODE_COUNT
 } app_mode_t;
 
 /**
- * @enum top_menu_action_t
- * @brief Enumerates the possible actions in the top menu.
+ * @struct app_mode_handlers_t
+ * @brief Input and render handlers of one application mode.
+ */
+typedef struct
+{
+	void (*on_encoder)(int delta); // encoder rotation
+	void (*on_click)();			   // encoder button click
+	void (*draw)();				   // screen renderer
+} app_mode_handlers_t;
+
+/**
+ * @brief Top menu items: X(action, label, handler).
  *
- * This enumeration defines the available actions that can be performed
- * from the application's top menu. The values are ordered and can be
- * used for indexing or iteration.
+ * The `top_menu_action_t` enum and the `top_menu_items[]` table are generated from this list.
+ */
+#define TOP_MENU_ITEMS(X)                                  \
+	X(TOP_MENU_SHIFT, "TIME SHIFT", app_menu_time_shift)   \
+	X(TOP_MENU_SUN_DAY, "SUN DAY", app_menu_sun_day)       \
+	X(TOP_MENU_SAVE, "SAVE", app_save_profiles)            \
+	X(TOP_MENU_RELOAD, "RELOAD", app_menu_reload)          \
+	X(TOP_MENU_COPY, "DUPLICATE", app_menu_copy_profile)   \
+	X(TOP_MENU_ALARMS, "CLR ALARM", app_menu_clear_alarms) \
+	X(TOP_MENU_JOURNAL, "JOURNAL", app_menu_journal)       \
+	X(TOP_MENU_DIAG, "DIAG", app_menu_diag)                \
+	X(TOP_MENU_FLASH, "FLASH", app_reboot_to_bootloader)
+
+/**
+ * @enum top_menu_action_t
+ * @brief Enumerates the possible actions in the top menu, see `TOP_MENU_ITEMS`.
  *
  * @var TOP_MENU_FIRST   The first menu action (used as a starting index).
- * @var TOP_MENU_SHIFT   Represents the "Shift" action in the top menu.
- * @var TOP_MENU_SAVE    Represents the "Save" action in the top menu.
- * @var TOP_MENU_RELOAD  Represents the "Reload" action in the top menu.
- * @var TOP_MENU_FLASH   Represents the "Flash" action in the top menu.
- * @var TOP_MENU_LAST    The last menu action (equal to TOP_MENU_FLASH).
+ * @var TOP_MENU_LAST    The last menu action.
  */
 typedef enum
 {
+#define TOP_MENU_ENUM(action, label, handler) action,
+	TOP_MENU_ITEMS(TOP_MENU_ENUM)
+#undef TOP_MENU_ENUM
+	TOP_MENU_COUNT,
 	TOP_MENU_FIRST = 0,
-	TOP_MENU_SHIFT = TOP_MENU_FIRST,
-	TOP_MENU_SAVE,
-	TOP_MENU_RELOAD,
-	TOP_MENU_FLASH,
-	TOP_MENU_LAST = TOP_MENU_FLASH
+	TOP_MENU_LAST  = TOP_MENU_COUNT - 1
 } top_menu_action_t;
 
+/**
+ * @struct app_menu_item_t
+ * @brief A labelled menu entry and the function run when it is clicked.
+ */
+typedef struct
+{
+	const char* label;
+	void (*action)();
+} app_menu_item_t;
+
+/**
+ * @brief Fields of the "Edit Period" screen: X(field, edit mode, formatter).
+ *
+ * Clicking a field switches to its edit mode; the formatter renders its line.
+ * The `edit_mode_t` enum and the `edit_fields[]` table are generated from this list.
+ */
+#define EDIT_FIELDS(X)                                               \
+	X(EDIT_BACK, MODE_EDIT_PROFILE, app_format_back)                 \
+	X(EDIT_DURATION, MODE_EDIT_DURATION, app_format_duration)        \
+	X(EDIT_WR_LEVEL, MODE_EDIT_WR_LEVEL, app_format_white_red_level) \
+	X(EDIT_BL_LEVEL, MODE_EDIT_BL_LEVEL, app_format_blue_level)
+
 /**
  * @enum edit_mode_t
- * @brief Enumeration representing the different editing modes in the application.
+ * @brief Enumeration representing the different editable fields of a period, see `EDIT_FIELDS`.
  *
- * The edit_mode_t enum defines the various states or modes that can be used
- * for editing parameters. The values are:
- * - EDIT_FIRST:      The first edit mode (used as a base value).
- * - EDIT_BACK:       Edit mode for "back" action (same as EDIT_FIRST).
- * - EDIT_DURATION:   Edit mode for modifying the duration parameter.
- * - EDIT_WR_LEVEL:   Edit mode for modifying the "WR" (possibly "write" or "white") level.
- * - EDIT_BL_LEVEL:   Edit mode for modifying the "BL" (possibly "black" or "blue") level.
- * - EDIT_LAST:       The last edit mode (same as EDIT_BL_LEVEL).
+ * @var EDIT_FIRST   The first field (used as a base value).
+ * @var EDIT_LAST    The last field.
  */
 typedef enum
 {
+#define EDIT_FIELD_ENUM(field, mode, format) field,
+	EDIT_FIELDS(EDIT_FIELD_ENUM)
+#undef EDIT_FIELD_ENUM
+	EDIT_COUNT,
 	EDIT_FIRST = 0,
-	EDIT_BACK  = EDIT_FIRST,
-	EDIT_DURATION,
-	EDIT_WR_LEVEL,
-	EDIT_BL_LEVEL,
-	EDIT_LAST = EDIT_BL_LEVEL
+	EDIT_LAST  = EDIT_COUNT - 1
 } edit_mode_t;
 
-static int			   current_profile = 0;			 // index of the current profile in use
-static absolute_time_t app_start_time;				 // time when the app was started
-static absolute_time_t app_start_time_without_shift; // time when the app was started without time shift
-static absolute_time_t last_encoder_time = 0;		 // last time the encoder was moved
+/**
+ * @struct app_edit_field_t
+ * @brief One line of the "Edit Period" screen.
+ */
+typedef struct
+{
+	app_mode_t mode;												   // mode entered on click
+	void (*format)(char* buffer, size_t size, const period_t* period); // renders the field line
+} app_edit_field_t;
+
+/**
+ * @brief Lines of the diagnostics screen: X(label, unit, getter).
+ *
+ * Each line shows the label followed by the value the getter returns and its unit. The screen scrolls
+ * when there are more lines than `APP_DIAG_ROWS`.
+ */
+#define DIAG_COUNTERS(X)                              \
+	X("FLASH ERASES", "", storage_erase_count)        \
+	X("FLASH BYTES", "", storage_program_bytes)       \
+	X("FLASH SKIPPED", "", storage_skipped_sectors)   \
+	X("SECTOR WEAR", "", storage_sector_wear)         \
+	X("AUTOSAVES", "", app_autosave_count)            \
+	X("TASK LATENCY", "us", task_max_latency_us)      \
+	X("OUTPUT UPDATE", "us", outputs_max_update_us)   \
+	X("DITHER IRQ", "cyc", outputs_dither_irq_cycles) \
+	X("DITHER PASSES", "", outputs_dither_passes)     \
+	X("STATE CALC", "us", app_max_state_us)           \
+	X("ADC OVERRUNS", "", sensors_overruns)
+
+/**
+ * @struct app_diag_counter_t
+ * @brief One line of the diagnostics screen, see `DIAG_COUNTERS`.
+ */
+typedef struct
+{
+	const char* label;
+	const char* unit;
+	uint32_t (*value)();
+} app_diag_counter_t;
+
+static int			   current_profile = 0;			   // index of the current profile in use
+static profile_t	   active_profile;				   // RAM copy of the current profile, the only one that is edited
+static uint32_t		   app_start_minute;			   // timebase minute when the app was started, with time shift
+static uint32_t		   app_start_minute_without_shift; // timebase minute when the app was started without time shift
+static absolute_time_t last_encoder_time = 0;		   // last time the encoder was moved
 static ssd1306_t	   disp;
 static app_state_t	   current_app_state	 = {.white_red = -1, .blue = -1}; // invalid state to force update on start
 
 static app_mode_t  current_app_mode			 = MODE_SHOW_STATE;
 static int		   menu_profile_index		 = 0;		  // index of the profile in the menu
 static int		   current_edit_period_index = 0;		  // index of the period being edited
+static ui_list_t   profile_list;						  // scroll state of the profile browser
+static ui_list_t   period_list;							  // scroll state of the "Edit Profile" screen
 static edit_mode_t current_edit_value		 = EDIT_BACK; // value being edited
+static ui_list_t   journal_list;						  // scroll state of the journal screen
+static int		   journal_index			 = 0;		  // journal event selected on the journal screen, 0 = newest
+static int		   diag_top					 = 0;		  // first line shown on the diagnostics screen
+
+static bool			   edit_open	   = false; // an edit session is open on `edit_period`
+static period_t		   edit_period;				// shadow copy of period `current_edit_period_index` while it is edited
+static absolute_time_t preview_time	   = 0;		// last time a preview level was applied to the outputs
+static bool			   preview_pending = false; // a preview level waits for the `APP_PREVIEW_MS` throttle
+
+static uint32_t schedule_end[MAX_PERIODS]; // cycle minute at which each period of `active_profile` ends
+static bool		schedule_valid = false;	   // `schedule_end` matches `active_profile`
 
 static top_menu_action_t current_top_menu_action = TOP_MENU_SAVE;
 
 static int time_shift_hours						 = 0; // hours to shift the time, can be negative
 
+static int		sun_day_of_year		 = SUN_DEFAULT_DAY; // day of year at `sun_day_minute`
+static uint32_t sun_day_minute		 = 0;				// timebase minute when the day of year was set
+static int		sun_computed_day	 = 0;				// day the SUN profile periods were computed for, 0 = none
+static int		sun_computed_profile = -1;				// profile the SUN periods were computed for
+static int		sun_edit_day		 = 0;				// day of year while MODE_SUN_DAY is open
+
+static bool display_blanked						 = false; // OLED switched off while idle
+static bool frame_drawn							 = false; // `app_redraw()` ran, reset before each click handler
+static uint32_t shown_alarms					 = 0; // latched alarm mask shown on the state screen
+static int32_t	shown_celsius					 = 0; // chip temperature shown on the state screen
+static int32_t	applied_scale_q8				 = THERMAL_SCALE_ONE; // thermal LED scale of the last applied state
+static bool		applied_pump_lockout			 = false; // pump held off by a latched alarm in the last applied state
+static int32_t	applied_trim_q8					 = LIGHT_TRIM_ONE; // daylight LED trim of the last applied state
+
+static task_t	   message_task;	  // keeps a status message on screen, then leaves MODE_MESSAGE
+static const char* message_text;	  // status message shown in MODE_MESSAGE
+static app_mode_t  message_next_mode; // mode to return to after the message
+static task_t	   reboot_task;		  // reboots to the bootloader once the message is on screen
+static task_t	   autosave_task;	  // writes the edited profile once the edits pause for `APP_AUTOSAVE_MS`
+static uint32_t	   autosave_count;	  // autosaves handed to storage since boot
+static uint32_t	   max_state_us;	  // longest schedule evaluation of `app_tick()`, timebase read included
+
+/**
+ * @brief Re-derives the OLED I2C baud rate after a system clock change.
+ *
+ * @param sys_hz The new system clock frequency in Hz (unused, the I2C driver reads it itself).
+ */
+static void app_on_clock_change(uint32_t sys_hz)
+{
+	i2c_set_baudrate(i2c1, OLED_I2C_BAUD);
+}
+
 /**
  * @brief Initializes the application hardware and state.
  *
  * This function sets up all peripherals and internal state required for the application to run.
  * It performs the following steps:
- *   - Resets the current profile and records the application start time.
- *   - Configures the LED pins for PWM output and initializes their PWM slices.
- *   - Sets initial LED levels to off.
- *   - Initializes the GPIO pin for the water pump and sets its direction.
+ *   - Resets the current profile and records the application start minute (`timebase_init()` must run first).
+ *   - Initializes the LED PWM outputs and the water pump pin (all off).
  *   - Initializes the I2C bus and configures the pins for the OLED display.
  *   - Initializes and clears the OLED display.
  *   - Loads profiles from flash memory (without UI feedback).
@@ -248,34 +356,24 @@ static int time_shift_hours						 = 0; // hours to shift the time, can be negati
  */
 void app_init()
 {
-	current_profile				 = 0;
-	app_start_time				 = get_absolute_time();
-	app_start_time_without_shift = app_start_time;
-
-	gpio_set_function(PIN_LED_BLUE, GPIO_FUNC_PWM);
-	gpio_set_function(PIN_LED_WHITE_RED, GPIO_FUNC_PWM);
+	current_profile				   = 0;
+	app_start_minute			   = timebase_minutes();
+	app_start_minute_without_shift = app_start_minute;
 
-	// Find out which PWM slice is connected to PIN_LED_BLUE
-	uint slice_num = pwm_gpio_to_slice_num(PIN_LED_BLUE);
+	outputs_init();
 
-	// Set period of 4 cycles (0 to 3 inclusive)
-	pwm_set_wrap(slice_num, PWM_WRAP);
-	// Set the PWM running
-	pwm_set_enabled(slice_num, true);
-
-	pwm_set_gpio_level(PIN_LED_BLUE, 0);
-	pwm_set_gpio_level(PIN_LED_WHITE_RED, 0);
-
-	// Init pin for water pump
-	gpio_init(PIN_PUMP);
-	gpio_set_dir(PIN_PUMP, GPIO_OUT);
+	ui_list_init(&profile_list, APP_PROFILE_ROWS, 16, APP_PROFILE_ACCEL, app_draw_profile_row);
+	ui_list_init(&period_list, APP_MENU_ROWS, 16, 1, app_draw_period_row);
+	ui_list_init(&journal_list, APP_MENU_ROWS, 16, APP_PROFILE_ACCEL, app_draw_journal_row);
+	period_list.count = 1 + MAX_PERIODS; // BACK and the periods
 
 	// Init I2C for OLED
-	i2c_init(i2c1, 400000);
+	i2c_init(i2c1, OLED_I2C_BAUD);
 	gpio_set_function(PIN_OLED_SDA, GPIO_FUNC_I2C);
 	gpio_set_function(PIN_OLED_SDL, GPIO_FUNC_I2C);
 	gpio_pull_up(PIN_OLED_SDA);
 	gpio_pull_up(PIN_OLED_SDL);
+	power_add_clock_listener(app_on_clock_change);
 
 	// Init OLED display
 	disp.external_vcc = false;
@@ -287,6 +385,83 @@ void app_init()
 	app_tick();
 }
 
+/**
+ * @brief Returns the day of year at the given timebase minute.
+ *
+ * The day advances every 1440 minutes from the moment it was set in MODE_SUN_DAY.
+ */
+static int app_day_of_year(uint32_t now_minutes)
+{
+	uint32_t days = (now_minutes - sun_day_minute) / SOLAR_DAY_MINUTES;
+	return (int) ((sun_day_of_year - 1 + days) % SOLAR_DAYS) + 1;
+}
+
+/**
+ * @brief Recomputes the periods of a SUN profile when the day of year changed.
+ *
+ * Period 1 gets the time from sunrise to sunset and period 2 the rest of the day, so the profile
+ * always spans exactly one day and the schedule position is not disturbed by the recomputation.
+ * The other periods are disabled.
+ *
+ * @param profile     The current profile, of type PROFILE_SUN.
+ * @param now_minutes The current timebase minute.
+ */
+static void app_update_sun_profile(profile_t* profile, uint32_t now_minutes)
+{
+	int day = app_day_of_year(now_minutes);
+	if(day == sun_computed_day && current_profile == sun_computed_profile)
+	{
+		return; // already up to date for today
+	}
+
+	int		 daylight = solar_day_length_minutes(profile->latitude, day);
+	period_t period;
+	profile_get_period(profile, 0, &period);
+	period.duration = daylight;
+	profile_set_period(profile, 0, &period);
+	profile_get_period(profile, 1, &period);
+	period.duration = SOLAR_DAY_MINUTES - daylight;
+	profile_set_period(profile, 1, &period);
+	for(int i = 2; i < MAX_PERIODS; i++)
+	{
+		profile->periods[i] = 0;
+	}
+	sun_computed_day	 = day;
+	sun_computed_profile = current_profile;
+	schedule_valid		 = false; // period durations changed
+}
+
+/**
+ * @brief Rebuilds the period timeline of the current profile: the cycle minute at which each period ends.
+ *
+ * Disabled periods end where the previous period ended, so they never match a cycle minute.
+ */
+static void app_build_schedule()
+{
+	uint32_t end = 0;
+	for(int i = 0; i < MAX_PERIODS; i++)
+	{
+		end				+= PERIOD_DURATION(active_profile.periods[i]);
+		schedule_end[i]	 = end;
+	}
+	schedule_valid = true;
+}
+
+/**
+ * @brief Updates the timeline after the duration of one period changed. The periods before it are
+ * not touched, the ones after it only move.
+ *
+ * @param index Index of the changed period.
+ * @param delta Change of its duration in minutes.
+ */
+static void app_update_schedule(int index, int delta)
+{
+	for(int i = index; i < MAX_PERIODS; i++)
+	{
+		schedule_end[i] += delta;
+	}
+}
+
 /**
  * @brief Calculates and updates the application state based on the current time and profile periods.
  *
@@ -295,8 +470,10 @@ void app_init()
  * It updates the global `current_app_state` structure accordingly.
  *
  * The function performs the following:
- * - Computes the number of minutes since the application started.
- * - Calculates the total duration of all active periods in the current profile.
+ * - Computes the number of minutes since the application started from the timebase minute counter,
+ *   so the tick path only uses 32-bit arithmetic.
+ * - Recomputes the day and night periods of a SUN profile once per day.
+ * - Rebuilds the period timeline (`schedule_end`) if the profile changed, and takes the cycle length from it.
  * - Handles pump operation based on a cyclic schedule (run/off periods).
  * - Determines the current active period and updates LED power levels and remaining time.
  * - Turns off LEDs if no active period is found.
@@ -305,20 +482,22 @@ void app_init()
  */
 static bool app_calculate_state()
 {
-	absolute_time_t now					= get_absolute_time();
-	uint64_t		us_since_start		= to_us_since_boot(now) - to_us_since_boot(app_start_time);
-	uint32_t		minutes_since_start = us_since_start / 1000000 / 60;
-	bool			ret					= false;
-
-	profile_t* profile					= &profiles[current_profile];
-	uint32_t   profile_total_minutes	= 0;
+	uint32_t now_minutes		 = timebase_minutes();
+	int32_t	 minutes_since_start = (int32_t) (now_minutes - app_start_minute); // negative after a forward time shift
+	bool	 ret				 = false;
 
-	for(int i = 0; i < MAX_PERIODS; i++)
+	profile_t* profile = &active_profile;
+	if(profile->type == PROFILE_SUN)
+	{
+		app_update_sun_profile(profile, now_minutes);
+	}
+	if(!schedule_valid)
 	{
-		profile_total_minutes += profile->periods[i].duration;
+		app_build_schedule();
 	}
+	uint32_t total_minutes = schedule_end[MAX_PERIODS - 1];
 
-	if(profile_total_minutes == 0)
+	if(total_minutes == 0)
 	{
 		if(current_app_state.white_red != 0 || current_app_state.blue != 0)
 		{
@@ -330,8 +509,7 @@ static bool app_calculate_state()
 	}
 
 	{
-		uint64_t us_since_start		 = to_us_since_boot(now) - to_us_since_boot(app_start_time_without_shift);
-		uint32_t minutes_since_start = us_since_start / 1000000 / 60;
+		uint32_t minutes_since_start = now_minutes - app_start_minute_without_shift;
 		uint32_t pump_cycle_position = minutes_since_start % PUMP_TOTAL_MINUTES;
 		if(pump_cycle_position < PUMP_RUN_MINUTES)
 		{
@@ -364,36 +542,36 @@ static bool app_calculate_state()
 		}
 	}
 
-	if(minutes_since_start >= profile_total_minutes)
+	if(minutes_since_start < 0 || minutes_since_start >= (int32_t) total_minutes)
 	{
-		minutes_since_start = minutes_since_start % profile_total_minutes;
+		minutes_since_start = minutes_since_start % (int32_t) total_minutes;
+		if(minutes_since_start < 0)
+		{
+			minutes_since_start += total_minutes;
+		}
 	}
 
-	uint32_t elapsed_minutes = 0;
 	for(int i = 0; i < MAX_PERIODS; i++)
 	{
-		period_t* period = &profile->periods[i];
-		if(period->duration == 0)
+		if((uint32_t) minutes_since_start >= schedule_end[i])
 		{
-			continue; // disabled period
+			continue; // period over, or disabled
 		}
-		if(minutes_since_start < elapsed_minutes + period->duration)
+		// we are in this period, unpack it
+		period_t period;
+		profile_decode_period(profile->periods[i], &period);
+		uint32_t minutes_left = schedule_end[i] - minutes_since_start;
+		if(current_app_state.white_red != period.led_white_red_power ||
+		   current_app_state.blue != period.led_blue_power || current_app_state.period_minutes_left != minutes_left ||
+		   current_app_state.period_index != i)
 		{
-			// we are in this period
-			if(current_app_state.white_red != period->led_white_red_power ||
-			   current_app_state.blue != period->led_blue_power ||
-			   current_app_state.period_minutes_left != elapsed_minutes + period->duration - minutes_since_start ||
-			   current_app_state.period_index != i)
-			{
-				current_app_state.white_red			  = period->led_white_red_power;
-				current_app_state.blue				  = period->led_blue_power;
-				current_app_state.period_minutes_left = elapsed_minutes + period->duration - minutes_since_start;
-				current_app_state.period_index		  = i;
-				return true; // state changed
-			}
-			return ret; // state not changed
+			current_app_state.white_red			  = period.led_white_red_power;
+			current_app_state.blue				  = period.led_blue_power;
+			current_app_state.period_minutes_left = minutes_left;
+			current_app_state.period_index		  = i;
+			return true; // state changed
 		}
-		elapsed_minutes += period->duration;
+		return ret; // state not changed
 	}
 
 	// no active period, turn off leds
@@ -407,30 +585,46 @@ static bool app_calculate_state()
 	return ret; // state not changed
 }
 
+/**
+ * @brief Converts a scheduled LED percentage to an output level with the thermal and daylight scaling applied.
+ */
+static uint32_t app_led_level(int percent)
+{
+	uint32_t level = OUTPUT_LEVEL_FROM_PERCENT(percent);
+	level		   = level * applied_scale_q8 >> 8;
+	return level * applied_trim_q8 >> 8;
+}
+
 /**
  * @brief Applies the current application state to the hardware.
  *
  * This function updates the hardware outputs based on the values stored in
  * the global `current_app_state` structure. It controls the pump and two LEDs:
- * - Turns the pump on or off depending on `current_app_state.pump`.
- * - Sets the PWM level for the white/red LED based on `current_app_state.white_red` (as a percentage).
- * - Sets the PWM level for the blue LED based on `current_app_state.blue` (as a percentage).
+ * - Turns the pump on or off depending on `current_app_state.pump`. The pump stays off while one of
+ *   the `PUMP_LOCKOUT_ALARMS` is latched.
+ * - Sets the white/red LED level based on `current_app_state.white_red` (as a percentage).
+ * - Sets the blue LED level based on `current_app_state.blue` (as a percentage).
+ * - Scales both LED levels by the thermal derating factor (`thermal_scale_q8()`) and the daylight
+ *   trim of the light controller (`light_trim_q8()`), and passes the scheduled level on to the
+ *   light controller as its target.
  *
- * Assumes that the GPIO and PWM peripherals have been initialized.
+ * Assumes that the outputs have been initialized with `outputs_init()`.
  */
 static void app_apply_state()
 {
 	// Apply the current state to the pump
-	if(current_app_state.pump)
-	{
-		gpio_put(PIN_PUMP, 1); // on
-	} else
-	{
-		gpio_put(PIN_PUMP, 0); // off
-	}
-
-	pwm_set_gpio_level(PIN_LED_WHITE_RED, current_app_state.white_red * PWM_WRAP / 100);
-	pwm_set_gpio_level(PIN_LED_BLUE, current_app_state.blue * PWM_WRAP / 100);
+	applied_pump_lockout = (alarms_latched() & PUMP_LOCKOUT_ALARMS) != 0;
+	outputs_set_pump(current_app_state.pump && !applied_pump_lockout);
+
+	applied_scale_q8 = thermal_scale_q8();
+	applied_trim_q8	 = light_trim_q8();
+	light_set_target_percent(current_app_state.white_red);
+
+	uint32_t levels[OUTPUT_LED_COUNT] = {
+		[OUTPUT_LED_WHITE_RED] = app_led_level(current_app_state.white_red),
+		[OUTPUT_LED_BLUE]	   = app_led_level(current_app_state.blue),
+	};
+	outputs_set_led_levels(levels);
 }
 
 /**
@@ -440,10 +634,12 @@ static void app_apply_state()
  * - The current profile name.
  * - A horizontal separator line.
  * - The current period index and the remaining time in hours and minutes.
- * - The current white/red and blue percentage values.
- * - The pump state (ON/OFF) and the remaining pump minutes.
+ * - The current white/red and blue percentage values, the chip temperature and a "*" while the
+ *   LEDs are thermally derated.
+ * - The pump state (ON/OFF) and the remaining pump minutes, or LOCKED while an alarm holds it off.
+ * - A "!" next to the profile name while any alarm is latched.
  *
- * The function uses the global variables `profiles`, `current_profile`, and `current_app_state`
+ * The function uses the global variables `active_profile` and `current_app_state`
  * to retrieve the necessary data for display.
  */
 static void app_draw_current_state()
@@ -454,7 +650,12 @@ static void app_draw_current_state()
 	ssd1306_clear(&disp);
 
 	// Draw profile name
-	ssd1306_draw_string(&disp, 0, y, 2, profiles[current_profile].name);
+	ssd1306_draw_string(&disp, 0, y, 2, active_profile.name);
+	shown_alarms = alarms_latched();
+	if(shown_alarms)
+	{
+		ssd1306_draw_string(&disp, 116, y, 2, "!");
+	}
 	y += 16;
 	ssd1306_draw_line(&disp, 0, y, 128, y);
 	ssd1306_draw_line(&disp, 0, y + 1, 128, y + 1);
@@ -467,12 +668,17 @@ static void app_draw_current_state()
 	ssd1306_draw_string(&disp, 0, y, 2, buffer);
 	y += 18;
 
-	snprintf(buffer, sizeof(buffer), "W/R:%d%% B:%d%%", current_app_state.white_red, current_app_state.blue);
+	shown_celsius = thermal_celsius10() / 10;
+	snprintf(buffer, sizeof(buffer), "W/R:%d%% B:%d%% %dC%s", current_app_state.white_red, current_app_state.blue,
+			 (int) shown_celsius, thermal_derating() ? "*" : "");
 	ssd1306_draw_string(&disp, 0, y, 1, buffer);
 	y += 10;
 
 	// Draw pump state
-	if(current_app_state.pump)
+	if(applied_pump_lockout)
+	{
+		snprintf(buffer, sizeof(buffer), "P:LOCKED");
+	} else if(current_app_state.pump)
 	{
 		snprintf(buffer, sizeof(buffer), "P:ON %dm", current_app_state.pump_minutes_left);
 	} else
@@ -485,48 +691,99 @@ static void app_draw_current_state()
 }
 
 /**
- * @brief Draws the current profile information on the SSD1306 display.
+ * @brief Returns the profile shown in the profile browser.
+ *
+ * The current profile comes from its RAM copy, which may hold unsaved edits. Any other profile is
+ * decoded from its flash record into a single RAM copy, so browsing copies one record at a time.
+ */
+static const profile_t* app_menu_profile()
+{
+	static profile_t browsed; // decoded record of the selected profile
+
+	if(menu_profile_index == current_profile)
+	{
+		return &active_profile;
+	}
+	storage_peek(menu_profile_index, &browsed);
+	return &browsed;
+}
+
+/**
+ * @brief Draws one row of the profile browser: the profile name, and a '*' on the profile in use.
+ *
+ * Names are read straight from the flash index, only the visible rows are ever fetched.
+ */
+static void app_draw_profile_row(int index, int x, int y)
+{
+	ssd1306_draw_string(&disp, x, y, 2, index == current_profile ? active_profile.name : storage_name(index));
+	if(index == current_profile)
+	{
+		ssd1306_draw_string(&disp, 116, y, 2, "*");
+	}
+}
+
+/**
+ * @brief Draws the profile browser on the SSD1306 display.
  *
- * This function clears the display and renders the selected profile's name and its periods.
- * For each period, it displays the period number, duration in hours, white/red LED power, and blue LED power.
- * The information is formatted and drawn line by line on the display.
+ * The upper rows list the profile names around the selection, scrolled by `profile_list`.
+ * The bottom lines show the first two periods of the selected profile: number, duration in hours,
+ * white/red LED power and blue LED power.
  *
- * Assumes that 'profiles', 'menu_profile_index', 'MAX_PERIODS', 'profile_t', 'period_t', and 'disp'
- * are defined elsewhere in the codebase.
+ * Profiles other than the current one are decoded from the flash library, see `app_menu_profile()`.
  */
 static void app_draw_profile()
 {
 	char buffer[32];
-	int	 y = 0;
-	int	 x = 0;
+	int	 y = APP_PROFILE_ROWS * 16;
 
 	ssd1306_clear(&disp);
 
-	profile_t* profile = &profiles[menu_profile_index];
-
-	// Draw profile name
-	ssd1306_draw_string(&disp, x, y, 2, profile->name);
-	y += 16;
+	profile_list.count = storage_count();
+	ui_list_draw(&profile_list, &disp, menu_profile_index);
 
-	for(int i = 0; i < MAX_PERIODS; i++)
+	const profile_t* profile = app_menu_profile();
+	for(int i = 0; i < 2; i++)
 	{
-		period_t* period = &profile->periods[i];
-		int		  hours	 = period->duration / 60;
-		snprintf(buffer, sizeof(buffer), "%d-T:%2d|W:%3d|B:%3d", i + 1, hours, period->led_white_red_power,
-				 period->led_blue_power);
-		ssd1306_draw_string(&disp, x, y, 1, buffer);
+		period_t period;
+		profile_get_period(profile, i, &period);
+		snprintf(buffer, sizeof(buffer), "%d-T:%2d|W:%3d|B:%3d", i + 1, period.duration / 60,
+				 period.led_white_red_power, period.led_blue_power);
+		ssd1306_draw_string(&disp, 0, y, 1, buffer);
 		y += 8;
 	}
 
 	ssd1306_show(&disp);
 }
 
+/**
+ * @brief Draws one row of the "Edit Profile" screen: BACK in row 0, then one row per period.
+ */
+static void app_draw_period_row(int index, int x, int y)
+{
+	char buffer[32];
+	if(index == 0)
+	{
+		ssd1306_draw_string(&disp, x, y, 2, "BACK");
+		return;
+	}
+
+	period_t period;
+	profile_get_period(&active_profile, index - 1, &period);
+	snprintf(buffer, sizeof(buffer), "%d-T:%2d", index, period.duration / 60);
+	ssd1306_draw_string(&disp, x, y, 2, buffer);
+
+	snprintf(buffer, sizeof(buffer), "W:%3d%%", period.led_white_red_power);
+	ssd1306_draw_string(&disp, 85, y, 1, buffer);
+	snprintf(buffer, sizeof(buffer), "B:%3d%%", period.led_blue_power);
+	ssd1306_draw_string(&disp, 85, y + 8, 1, buffer);
+}
+
 /**
  * @brief Draws the "Edit Profile" screen on the SSD1306 display.
  *
- * This function clears the display and renders the UI for editing a profile's periods.
- * It highlights the currently selected period, displays a "BACK" option, and lists up to
- * MAX_PERIODS periods starting from a calculated top index. For each period, it shows:
+ * This function clears the display and renders the UI for editing a profile's periods through
+ * `period_list`: a "BACK" option followed by the MAX_PERIODS periods, scrolled so the selection stays
+ * visible. For each period, `app_draw_period_row()` shows:
  *   - The period index and duration in hours.
  *   - The white/red LED power percentage.
  *   - The blue LED power percentage.
@@ -535,70 +792,58 @@ static void app_draw_profile()
  * Globals used:
  *   - disp: The SSD1306 display context.
  *   - current_edit_period_index: Index of the currently selected period.
- *   - profiles: Array of profile structures containing periods.
- *   - menu_profile_index: Index of the currently selected profile.
- *
- * Functions used:
- *   - ssd1306_clear: Clears the display.
- *   - ssd1306_draw_string: Draws a string on the display at a given position and size.
- *   - ssd1306_show: Updates the display with the drawn content.
+ *   - active_profile: RAM copy of the profile being edited.
  */
 static void app_draw_edit_profile()
 {
-	char buffer[32];
-	int	 y = 0;
-	int	 x = 0;
-
 	ssd1306_clear(&disp);
+	ui_list_draw(&period_list, &disp, current_edit_period_index + 1); // row 0 is BACK
+	ssd1306_show(&disp);
+}
 
-	if(current_edit_period_index < 0)
-	{
-		ssd1306_draw_string(&disp, x, y, 2, ">"); // indicate selected period
-	}
-	ssd1306_draw_string(&disp, x + 11, y, 2, "BACK");
-	y			  += 16;
-
-	int top_index  = current_edit_period_index - 2;
-	if(top_index < 0)
-	{
-		top_index = 0;
-	}
-
-	for(int i = top_index; i < MAX_PERIODS; i++)
-	{
-		period_t* period = &profiles[menu_profile_index].periods[i];
-		int		  hours	 = period->duration / 60;
-		snprintf(buffer, sizeof(buffer), "%d-T:%2d", i + 1, hours);
-		if(i == current_edit_period_index)
-		{
-			ssd1306_draw_string(&disp, x, y, 2, ">"); // indicate selected period
-		}
-		ssd1306_draw_string(&disp, x + 10, y, 2, buffer);
+/**
+ * @brief Formatters for the "Edit Period" fields, see `EDIT_FIELDS`.
+ *
+ * @param buffer The output buffer.
+ * @param size   The size of the output buffer.
+ * @param period The period being edited.
+ */
+static void app_format_back(char* buffer, size_t size, const period_t* period)
+{
+	snprintf(buffer, size, "BACK");
+}
 
-		snprintf(buffer, sizeof(buffer), "W:%3d%%", period->led_white_red_power);
-		ssd1306_draw_string(&disp, x + 85, y, 1, buffer);
-		snprintf(buffer, sizeof(buffer), "B:%3d%%", period->led_blue_power);
-		ssd1306_draw_string(&disp, x + 85, y + 8, 1, buffer);
+static void app_format_duration(char* buffer, size_t size, const period_t* period)
+{
+	snprintf(buffer, size, "TIME:%d", period->duration / 60);
+}
 
-		y += 16;
-	}
+static void app_format_white_red_level(char* buffer, size_t size, const period_t* period)
+{
+	snprintf(buffer, size, "WRED:%3d%%", period->led_white_red_power);
+}
 
-	ssd1306_show(&disp);
+static void app_format_blue_level(char* buffer, size_t size, const period_t* period)
+{
+	snprintf(buffer, size, "BLUE:%3d%%", period->led_blue_power);
 }
 
+static const app_edit_field_t edit_fields[EDIT_COUNT] = {
+#define EDIT_FIELD_ENTRY(field, edit_mode, formatter) [field] = {.mode = edit_mode, .format = formatter},
+	EDIT_FIELDS(EDIT_FIELD_ENTRY)
+#undef EDIT_FIELD_ENTRY
+};
+
 /**
  * @brief Draws the "Edit Period" screen on the SSD1306 display.
  *
- * This function displays the editable parameters of a period (duration, white/red LED power, blue LED power)
- * for the currently selected profile and period. It visually indicates which parameter is currently selected
- * or being edited using special symbols ('>' for selected, '=' for editing). The "BACK" option is also shown
- * at the top to allow returning to the previous menu.
+ * This function displays the fields listed in `EDIT_FIELDS` (back, duration, white/red LED power,
+ * blue LED power) for the currently selected profile and period. It visually indicates which field is
+ * currently selected or being edited using special symbols ('>' for selected, '=' for editing).
  *
  * The function uses the following global variables:
- * - profiles: Array of profile_t structures containing period data.
- * - current_profile: Index of the currently selected profile.
- * - current_edit_period_index: Index of the period being edited.
- * - current_edit_value: Indicates which field is currently selected (e.g., BACK, DURATION, WR_LEVEL, BL_LEVEL).
+ * - edit_period: Shadow copy of the period being edited.
+ * - current_edit_value: Indicates which field is currently selected.
  * - current_app_mode: Indicates the current editing mode (e.g., MODE_EDIT_DURATION, MODE_EDIT_WR_LEVEL, etc.).
  *
  * The function updates the display using the SSD1306 driver functions.
@@ -611,57 +856,19 @@ static void app_draw_edit_period()
 
 	ssd1306_clear(&disp);
 
-	profile_t* profile = &profiles[current_profile];
-	period_t*  period  = &profile->periods[current_edit_period_index];
-	int		   hours   = period->duration / 60;
-
-	if(current_edit_value == EDIT_BACK)
-	{
-		ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected value
-	}
-	ssd1306_draw_string(&disp, x, y, 2, "BACK");
-	y += 16;
-
-	if(current_edit_value == EDIT_DURATION)
-	{
-		if(current_app_mode == MODE_EDIT_DURATION)
-		{
-			ssd1306_draw_string(&disp, 0, y, 2, "="); // indicate selected value
-		} else
-		{
-			ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected value
-		}
-	}
-	snprintf(buffer, sizeof(buffer), "TIME:%d", hours);
-	ssd1306_draw_string(&disp, x, y, 2, buffer);
-	y += 16;
-
-	if(current_edit_value == EDIT_WR_LEVEL)
-	{
-		if(current_app_mode == MODE_EDIT_WR_LEVEL)
-		{
-			ssd1306_draw_string(&disp, 0, y, 2, "="); // indicate selected value
-		} else
-		{
-			ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected value
-		}
-	}
-	snprintf(buffer, sizeof(buffer), "WRED:%3d%%", period->led_white_red_power);
-	ssd1306_draw_string(&disp, x, y, 2, buffer);
-	y += 16;
+	const period_t* period = &edit_period; // the screen is only shown during an edit session
 
-	if(current_edit_value == EDIT_BL_LEVEL)
+	for(int i = EDIT_FIRST; i <= EDIT_LAST; i++)
 	{
-		if(current_app_mode == MODE_EDIT_BL_LEVEL)
+		if(i == current_edit_value)
 		{
-			ssd1306_draw_string(&disp, 0, y, 2, "="); // indicate selected value
-		} else
-		{
-			ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected value
+			// '=' while the value is being edited, '>' while it is only selected
+			ssd1306_draw_string(&disp, 0, y, 2, current_app_mode == edit_fields[i].mode ? "=" : ">");
 		}
+		edit_fields[i].format(buffer, sizeof(buffer), period);
+		ssd1306_draw_string(&disp, x, y, 2, buffer);
+		y += 16;
 	}
-	snprintf(buffer, sizeof(buffer), "BLUE:%3d%%", period->led_blue_power);
-	ssd1306_draw_string(&disp, x, y, 2, buffer);
 
 	ssd1306_show(&disp);
 }
@@ -696,285 +903,582 @@ static void app_draw_time_shift()
 }
 
 /**
- * @brief Draws the top menu on the SSD1306 display.
- *
- * This function clears the display and draws the top menu options:
- * "TIME SHIFT", "SAVE", "RELOAD", and "FLASH". It highlights the currently
- * selected menu action by drawing a '>' indicator next to it.
- *
- * The selection is determined by the value of the global variable
- * `current_top_menu_action`, which should be set to one of the following:
- * - TOP_MENU_SHIFT
- * - TOP_MENU_SAVE
- * - TOP_MENU_RELOAD
- * - TOP_MENU_FLASH
- *
- * The function uses the SSD1306 display driver functions to render the menu.
+ * @brief Draws the day of year used by SUN profiles, and the resulting daylight when a SUN profile is active.
  */
-static void app_draw_top_menu()
+static void app_draw_sun_day()
 {
-	int y = 0;
-	int x = 11;
+	char buffer[32];
+	int	 y = 0;
 
 	ssd1306_clear(&disp);
 
-	if(current_top_menu_action == TOP_MENU_SHIFT)
-	{
-		ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected action
-	}
-	ssd1306_draw_string(&disp, x, y, 2, "TIME SHIFT");
-	y += 16;
-
-	if(current_top_menu_action == TOP_MENU_SAVE)
-	{
-		ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected action
-	}
-	ssd1306_draw_string(&disp, x, y, 2, "SAVE");
+	snprintf(buffer, sizeof(buffer), "DAY OF YEAR:");
+	ssd1306_draw_string(&disp, 0, y, 2, buffer);
 	y += 16;
 
-	if(current_top_menu_action == TOP_MENU_RELOAD)
-	{
-		ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected action
-	}
-	ssd1306_draw_string(&disp, x, y, 2, "RELOAD");
-	y += 16;
+	snprintf(buffer, sizeof(buffer), "%d", sun_edit_day);
+	ssd1306_draw_string(&disp, 30, y, 4, buffer);
+	y += 32;
 
-	if(current_top_menu_action == TOP_MENU_FLASH)
+	const profile_t* profile = &active_profile;
+	if(profile->type == PROFILE_SUN)
 	{
-		ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected action
+		int daylight = solar_day_length_minutes(profile->latitude, sun_edit_day);
+		snprintf(buffer, sizeof(buffer), "LIGHT %02d:%02d", daylight / 60, daylight % 60);
+		ssd1306_draw_string(&disp, 0, y, 2, buffer);
 	}
-	ssd1306_draw_string(&disp, x, y, 2, "FLASH");
 
 	ssd1306_show(&disp);
 }
 
 /**
- * @brief Redraws the application UI based on the current application mode.
- *
- * This function checks the value of the global variable `current_app_mode`
- * and calls the appropriate drawing function to update the display.
- * Each case in the switch statement corresponds to a different application mode,
- * such as showing the current state, profile, editing profile or period, top menu,
- * or time shift. If the mode does not match any known value, the function does nothing.
+ * @brief Returns the autosaves handed to storage since boot, for the diagnostics screen.
  */
-static void app_redraw()
+static uint32_t app_autosave_count()
 {
-	switch(current_app_mode)
-	{
-	case MODE_SHOW_STATE:
-		app_draw_current_state();
-		break;
-	case MODE_SHOW_PROFILE:
-		app_draw_profile();
-		break;
-	case MODE_EDIT_PROFILE:
-		app_draw_edit_profile();
-		break;
-	case MODE_EDIT_PERIOD:
-	case MODE_EDIT_BL_LEVEL:
-	case MODE_EDIT_WR_LEVEL:
-	case MODE_EDIT_DURATION:
-		app_draw_edit_period();
-		break;
-	case MODE_TOP_MENU:
-		app_draw_top_menu();
-		break;
-	case MODE_TIME_SHIFT:
-		app_draw_time_shift();
-		break;
-	default:
-		break;
-	}
+	return autosave_count;
 }
 
 /**
- * @brief Reboots the device into bootloader mode for firmware flashing.
- *
- * This function clears the display, shows a message indicating that the device is preparing
- * to flash new firmware, and then sets a specific magic value at a predefined memory address
- * to signal the bootloader. It then calls `reset_usb_boot()` to initiate the reboot process.
- * The function enters an infinite loop to prevent further code execution after the reboot is triggered.
- *
- * Note:
- * - The magic value and memory address are specific to the device's bootloader implementation.
- * - This function is typically used when a firmware update is required via USB.
+ * @brief Returns the longest time `app_tick()` spent reading the timebase and evaluating the schedule,
+ * see `app_calculate_state()`, for the diagnostics screen.
  */
-static void app_reboot_to_bootloader()
+static uint32_t app_max_state_us()
 {
-	ssd1306_clear(&disp);
+	return max_state_us;
+}
 
-	ssd1306_draw_string(&disp, 0, 24, 2, "TO FLASH...");
+static const app_diag_counter_t diag_counters[] = {
+#define DIAG_COUNTER_ENTRY(counter_label, counter_unit, getter) \
+	{.label = counter_label, .unit = counter_unit, .value = getter},
+	DIAG_COUNTERS(DIAG_COUNTER_ENTRY)
+#undef DIAG_COUNTER_ENTRY
+};
 
-	ssd1306_show(&disp);
-	// Reboot to bootloader for flashing new firmware
-	const uint32_t BOOTLOADER_MAGIC = 0xF01669EF;
-	uint32_t*	   bootloader_magic = (uint32_t*) 0x20041FF0;
+/**
+ * @brief Draws the diagnostics counters listed in `DIAG_COUNTERS` at scale 1, from line `diag_top` on:
+ * flash wear of the profile library since boot (total erases and bytes, skipped writes, erases of the most
+ * worn sector and autosaves), task scheduling latency, the longest output update and schedule evaluation,
+ * and lost ADC batches.
+ */
+static void app_draw_diag()
+{
+	char buffer[32];
+	int	 y = 0;
+
+	ssd1306_clear(&disp);
+
+	for(int i = diag_top; i < (int) count_of(diag_counters) && i < diag_top + APP_DIAG_ROWS; i++)
+	{
+		snprintf(buffer, sizeof(buffer), "%s %lu%s", diag_counters[i].label,
+				 (unsigned long) diag_counters[i].value(), diag_counters[i].unit);
+		ssd1306_draw_string(&disp, 0, y, 1, buffer);
+		y += 8;
+	}
+
+	ssd1306_show(&disp);
+}
+
+/**
+ * @brief Draws one event of the journal screen at scale 1: label and argument on the first line,
+ * boot number and time since that boot on the second.
+ */
+static void app_draw_journal_row(int index, int x, int y)
+{
+	char			buffer[32];
+	journal_event_t event;
+	if(!journal_read(index, &event))
+	{
+		return;
+	}
+	snprintf(buffer, sizeof(buffer), "%s %d", journal_label(event.type), event.arg);
+	ssd1306_draw_string(&disp, x, y, 1, buffer);
+	snprintf(buffer, sizeof(buffer), "B%u %lu:%02lu:%02lu", event.boot, (unsigned long) event.seconds / 3600,
+			 (unsigned long) event.seconds / 60 % 60, (unsigned long) event.seconds % 60);
+	ssd1306_draw_string(&disp, x, y + 8, 1, buffer);
+}
+
+/**
+ * @brief Draws the journal screen, newest event first, scrolled by `journal_list`.
+ */
+static void app_draw_journal()
+{
+	ssd1306_clear(&disp);
+	journal_list.count = journal_count();
+	if(journal_list.count == 0)
+	{
+		ssd1306_draw_string(&disp, 0, 24, 2, "NO EVENTS");
+	}
+	ui_list_draw(&journal_list, &disp, journal_index);
+	ssd1306_show(&disp);
+}
+
+/**
+ * @brief Draws the current status message on the SSD1306 display.
+ */
+static void app_draw_message()
+{
+	ssd1306_clear(&disp);
+	ssd1306_draw_string(&disp, 0, 24, 2, message_text);
+	ssd1306_show(&disp);
+}
+
+/**
+ * @brief Task that keeps the status message on screen for `APP_MESSAGE_MS`, then returns to
+ * `message_next_mode` and redraws. Runs from the main loop, so inputs and outputs are serviced
+ * while the message is shown.
+ */
+static task_status_t app_message_task(task_t* task)
+{
+	TASK_BEGIN(task);
+	TASK_SLEEP_MS(task, APP_MESSAGE_MS);
+
+	menu_profile_index = current_profile;
+	current_app_mode   = message_next_mode;
+	app_redraw();
+
+	TASK_END(task);
+}
+
+/**
+ * @brief Shows a status message and returns to the given mode after `APP_MESSAGE_MS`.
+ *
+ * Input is ignored while the message is shown. Does not block.
+ *
+ * @param text      The message to show.
+ * @param next_mode The mode to switch to when the message times out.
+ */
+static void app_show_message(const char* text, app_mode_t next_mode)
+{
+	message_text	  = text;
+	message_next_mode = next_mode;
+	current_app_mode  = MODE_MESSAGE;
+	app_redraw();
+	task_start(&message_task, app_message_task);
+}
+
+/**
+ * @brief Encoder and click handler for modes that ignore input.
+ */
+static void app_encoder_ignore(int delta)
+{
+}
+
+static void app_click_ignore()
+{
+}
+
+/**
+ * @brief Task that reboots the device into bootloader mode for firmware flashing.
+ *
+ * The "TO FLASH..." message is drawn first; the task yields once so the main loop finishes
+ * the current pass, then sets a specific magic value at a predefined memory address
+ * to signal the bootloader and calls `reset_usb_boot()` to initiate the reboot process.
+ *
+ * Note:
+ * - The magic value and memory address are specific to the device's bootloader implementation.
+ * - This function is typically used when a firmware update is required via USB.
+ */
+static task_status_t app_reboot_task(task_t* task)
+{
+	TASK_BEGIN(task);
+	TASK_YIELD(task);
+
+	journal_log(JOURNAL_BOOTLOADER, 0);
+	journal_flush(); // staged events would be lost with the reboot
+
+	// Reboot to bootloader for flashing new firmware
+	const uint32_t BOOTLOADER_MAGIC = 0xF01669EF;
+	uint32_t*	   bootloader_magic = (uint32_t*) 0x20041FF0;
 	*bootloader_magic				= BOOTLOADER_MAGIC;
 	reset_usb_boot(0, 0);
-	while(1)
-		;
+
+	TASK_END(task);
 }
 
 /**
- * @brief Buffer used to temporarily store data for a flash memory sector.
+ * @brief Reboots the device into bootloader mode for firmware flashing.
  *
- * This buffer has a size equal to FLASH_SECTOR_SIZE and is typically used
- * for read, write, or erase operations involving flash memory sectors.
+ * Shows a message indicating that the device is preparing to flash new firmware and starts
+ * `app_reboot_task` to perform the reboot.
  */
-uint8_t flash_buffer[FLASH_SECTOR_SIZE];
+static void app_reboot_to_bootloader()
+{
+	message_text	 = "TO FLASH...";
+	current_app_mode = MODE_MESSAGE;
+	app_redraw();
+	task_start(&reboot_task, app_reboot_task);
+}
 
 /**
- * @brief Saves the current profile and all profiles to flash memory.
- *
- * This function prepares a buffer with magic bytes and profile data,
- * disables interrupts, erases the target flash sector, and writes the buffer
- * to flash memory. After saving, it displays a "SAVED..." message on the
- * SSD1306 display for 2 seconds, updates the menu profile index and app mode,
- * and redraws the application UI.
+ * @brief Saves the current profile and the current profile index to the flash library.
  *
- * The function ensures data integrity by using magic bytes and disabling
- * interrupts during the flash operation.
+ * Only the RAM copy of the current profile can hold edits, so only its record is rewritten, and
+ * only if it differs from flash. Every write is read back and checked against its CRC. After saving,
+ * it displays a "SAVED..." message ("UNCHANGED" if flash already held the data, "SAVE ERROR" if a
+ * write did not verify) on the SSD1306 display for `APP_MESSAGE_MS` without blocking, then returns
+ * to the state screen.
  */
 static void app_save_profiles()
 {
-	uint32_t FLASH_TARGET_OFFSET = PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE;
-	flash_buffer[0]				 = 0xA5; // magic byte to indicate valid data
-	flash_buffer[1]				 = 0x5A; // magic byte to indicate valid data
-	flash_buffer[2]				 = 0xA5; // magic byte to indicate valid data
-	flash_buffer[3]				 = 0x5A; // magic byte to indicate valid data
-	memcpy(flash_buffer + 4, &current_profile, sizeof(current_profile));
-	memcpy(flash_buffer + 4 + sizeof(current_profile), &profiles, sizeof(profiles));
+	uint32_t programmed = storage_program_bytes();
+	bool	 ok			= storage_save(current_profile, &active_profile);
+	ok					= storage_set_current(current_profile) && ok;
+	journal_log(ok ? JOURNAL_SAVE : JOURNAL_SAVE_ERROR, current_profile);
 
-	uint32_t ints = save_and_disable_interrupts();
-	flash_range_erase(FLASH_TARGET_OFFSET, FLASH_SECTOR_SIZE);
-	flash_range_program(FLASH_TARGET_OFFSET, flash_buffer, sizeof(flash_buffer));
-	restore_interrupts(ints);
-
-	ssd1306_clear(&disp);
-	ssd1306_draw_string(&disp, 0, 24, 2, "SAVED...");
-	ssd1306_show(&disp);
-	sleep_ms(2000);
+	if(!ok)
+	{
+		app_show_message("SAVE ERROR", MODE_SHOW_STATE);
+	} else
+	{
+		app_show_message(storage_program_bytes() == programmed ? "UNCHANGED" : "SAVED...", MODE_SHOW_STATE);
+	}
+}
 
+/**
+ * @brief Makes another profile of the library the current one.
+ *
+ * Edits of the profile in use are written back first: the pending autosave is handed to the storage
+ * right away and flushed, so a deferred write already in progress is completed rather than dropped.
+ * The new profile is then copied into RAM.
+ *
+ * @param index Index of the profile in the library.
+ * @return false if writing back the edits did not verify (logged as JOURNAL_SAVE_ERROR).
+ */
+static bool app_switch_profile(int index)
+{
+	task_stop(&autosave_task);
+	storage_save_deferred(current_profile, &active_profile);
+	bool ok = storage_flush_deferred();
+	if(!ok)
+	{
+		journal_log(JOURNAL_SAVE_ERROR, current_profile);
+	}
+	current_profile = index;
+	storage_load(current_profile, &active_profile);
+	schedule_valid	   = false;
 	menu_profile_index = current_profile;
-	current_app_mode   = MODE_SHOW_STATE;
+	journal_log(JOURNAL_PROFILE, current_profile);
+	return ok;
+}
 
-	app_redraw();
+/**
+ * @brief Task that waits until the edits pause for `APP_AUTOSAVE_MS`, then hands the current profile
+ * to the storage for a background write. Restarted by every edit, so a burst of edits is written once.
+ */
+static task_status_t app_autosave_task(task_t* task)
+{
+	TASK_BEGIN(task);
+	TASK_SLEEP_MS(task, APP_AUTOSAVE_MS);
+
+	storage_save_deferred(current_profile, &active_profile);
+	journal_log(JOURNAL_AUTOSAVE, current_profile);
+	autosave_count++;
+
+	TASK_END(task);
 }
 
 /**
- * @brief Reloads user profiles from flash memory and updates the application state.
+ * @brief Marks the current profile as edited and (re)schedules its autosave.
  *
- * This function reads profile data from a specific location in flash memory.
- * It first checks for a valid data signature (0xA5, 0x5A, 0xA5, 0x5A) at the beginning
- * of the data block. If the signature is invalid, it optionally updates the UI to indicate
- * that no data is available and returns early.
+ * The write happens `APP_AUTOSAVE_MS` after the last edit and one flash operation per main loop pass, see
+ * `storage_save_deferred()`, so the encoder and the outputs stay responsive while it runs. SAVE still
+ * writes at once.
+ */
+static void app_mark_dirty()
+{
+	task_start(&autosave_task, app_autosave_task);
+}
+
+/**
+ * @brief Pushes the previewed levels in `current_app_state` to the outputs, at most once per `APP_PREVIEW_MS`.
  *
- * If valid data is found, it loads the current profile index and the profiles array from flash.
- * If the loaded profile index is out of bounds, it resets it to 0.
- * The function also updates the menu profile index and sets the application mode to show the state.
- * Optionally, it updates the UI to indicate that data has been loaded.
+ * Levels that arrive within the interval stay pending and are applied by `app_tick()` once it is over,
+ * so the last level of a fast turn always reaches the LEDs.
+ */
+static void app_preview_apply()
+{
+	preview_pending = true;
+	if(absolute_time_diff_us(preview_time, get_absolute_time()) < APP_PREVIEW_MS * 1000)
+	{
+		return;
+	}
+	preview_pending = false;
+	preview_time	= get_absolute_time();
+	app_apply_state();
+}
+
+/**
+ * @brief Restores the outputs to the schedule after a preview.
+ */
+static void app_preview_end()
+{
+	preview_pending = false;
+	app_calculate_state();
+	app_apply_state();
+}
+
+/**
+ * @brief Opens an edit session on period `current_edit_period_index` and previews its levels.
  *
- * @param with_ui If true, updates the UI to reflect the loading status.
+ * The period is copied into `edit_period`; the editors change only that copy, so the profile and the
+ * schedule stay untouched until `app_edit_commit()`.
  */
-static void app_reload_profiles(bool with_ui)
+static void app_edit_begin()
+{
+	profile_get_period(&active_profile, current_edit_period_index, &edit_period);
+	edit_open					= true;
+	current_app_state.white_red = edit_period.led_white_red_power;
+	current_app_state.blue		= edit_period.led_blue_power;
+	app_preview_apply();
+}
+
+/**
+ * @brief Closes the edit session and writes the edited period back to the current profile.
+ *
+ * A changed duration only shifts the timeline from this period on, see `app_update_schedule()`; a level
+ * change needs no timeline update at all. The profile is marked for autosave if anything changed.
+ */
+static void app_edit_commit()
 {
-	uint8_t* address = (uint8_t*) (XIP_BASE + PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE);
-	if(address[0] != 0xA5 || address[1] != 0x5A || address[2] != 0xA5 || address[3] != 0x5A)
+	period_t original;
+	profile_get_period(&active_profile, current_edit_period_index, &original);
+	edit_open = false;
+	if(memcmp(&original, &edit_period, sizeof(original)) != 0)
 	{
-		// no valid data
-		if(with_ui)
+		profile_set_period(&active_profile, current_edit_period_index, &edit_period);
+		if(schedule_valid)
 		{
-			ssd1306_clear(&disp);
-			ssd1306_draw_string(&disp, 0, 24, 2, "NO DATA");
-			ssd1306_show(&disp);
-			sleep_ms(2000);
-			app_redraw();
+			app_update_schedule(current_edit_period_index, edit_period.duration - original.duration);
 		}
+		app_mark_dirty();
+	}
+	app_preview_end();
+}
+
+/**
+ * @brief Closes the edit session and drops the edited copy. The profile never saw the edits, only the
+ * outputs have to go back to the schedule.
+ */
+static void app_edit_cancel()
+{
+	if(!edit_open)
+	{
 		return;
 	}
-	memcpy(&current_profile, address + 4, sizeof(current_profile));
-	memcpy(&profiles, address + 4 + sizeof(current_profile), sizeof(profiles));
-	if(current_profile < 0 || current_profile >= MAX_PROFILES)
+	edit_open = false;
+	app_preview_end();
+}
+
+/**
+ * @brief Formats the flash library when it is empty.
+ *
+ * The profiles saved by earlier firmware in the last flash sector are imported if its save is found
+ * there, see `storage_read_legacy()`. Otherwise the library starts with `default_profiles`.
+ *
+ * @return true if saved profiles were imported, false if the defaults were used.
+ */
+static bool app_format_library()
+{
+	profile_t legacy[STORAGE_LEGACY_PROFILES];
+	int		  current;
+	int		  count = storage_read_legacy(legacy, &current);
+	if(count > 0)
 	{
-		current_profile = 0; // invalid profile index, reset to 0
+		storage_format(legacy, count, current);
+		return true;
 	}
+	storage_format(default_profiles, count_of(default_profiles), 0);
+	return false;
+}
+
+/**
+ * @brief Reloads the current profile from the flash library and updates the application state.
+ *
+ * Unsaved edits of the current profile are discarded: the autosave task is stopped and a deferred save
+ * that has not been written yet is dropped, so neither can write the old edits over the reloaded data.
+ * An empty library is formatted first, see
+ * `app_format_library()`. Only the current profile is copied into RAM, the others stay in flash.
+ * A record that fails its CRC check is replaced by the first default profile.
+ *
+ * The function also updates the menu profile index and sets the application mode to show the state.
+ * Optionally, it shows a non-blocking status message indicating whether data has been loaded.
+ *
+ * @param with_ui If true, updates the UI to reflect the loading status.
+ */
+static void app_reload_profiles(bool with_ui)
+{
+	task_stop(&autosave_task);
+	storage_drop_deferred();
+	bool loaded = storage_init() || app_format_library();
+
+	current_profile = storage_current();
+	if(!storage_load(current_profile, &active_profile))
+	{
+		active_profile = default_profiles[0]; // damaged record
+		loaded		   = false;
+	}
+	sun_computed_day   = 0; // periods of a SUN profile have to be recomputed
+	schedule_valid	   = false;
 	menu_profile_index = current_profile;
 	current_app_mode   = MODE_SHOW_STATE;
 	if(with_ui)
 	{
-		ssd1306_clear(&disp);
-		ssd1306_draw_string(&disp, 0, 24, 2, "DATA LOADED");
-		ssd1306_show(&disp);
-		sleep_ms(2000);
-		app_redraw();
+		app_show_message(loaded ? "DATA LOADED" : "NO DATA", MODE_SHOW_STATE);
 	}
 }
 
+/**
+ * @brief Checks whether the UI has been left alone for longer than `UI_IDLE_TIMEOUT_MS`.
+ */
+static bool app_ui_timed_out()
+{
+	return absolute_time_diff_us(last_encoder_time, get_absolute_time()) > UI_IDLE_TIMEOUT_MS * 1000;
+}
+
 /**
  * @brief Periodic application tick handler.
  *
  * This function is called periodically to handle application state updates.
- * - Checks if 10 seconds have passed since the last encoder event (`last_encoder_time`).
- *   - If so, and the current mode is not `MODE_SHOW_STATE`, switches to `MODE_SHOW_STATE`,
- *     sets the menu profile index to the current profile, and triggers a redraw.
+ * - Applies a preview level held back by the `APP_PREVIEW_MS` throttle.
+ * - Checks if `UI_IDLE_TIMEOUT_MS` have passed since the last encoder event (`last_encoder_time`).
+ *   - If so, and the current mode is not `MODE_SHOW_STATE`, cancels an open edit session, switches to
+ *     `MODE_SHOW_STATE`, sets the menu profile index to the current profile, and triggers a redraw.
+ *   - If `IDLE_BLANK_DISPLAY` is enabled, switches the OLED off. Redraws keep updating the
+ *     display RAM while it is off, so the first input shows an up-to-date frame immediately.
  * - If the current mode is `MODE_SHOW_STATE`:
  *   - Calls `app_calculate_state()`. If it returns true, applies the new state and redraws the UI.
+ *     The longest call is kept for the diagnostics screen.
+ *   - Otherwise redraws if the latched alarms or the shown temperature changed.
+ * - Re-applies the state whenever the thermal derating scale, the daylight trim or the pump lockout changed.
  */
 void app_tick()
 {
-	absolute_time_t now = get_absolute_time();
-	if(now - last_encoder_time > 10000 * 6000) // 10 seconds
+	if(thermal_scale_q8() != applied_scale_q8 || light_trim_q8() != applied_trim_q8 ||
+	   ((alarms_latched() & PUMP_LOCKOUT_ALARMS) != 0) != applied_pump_lockout)
+	{
+		app_apply_state();
+		if(current_app_mode == MODE_SHOW_STATE)
+		{
+			app_redraw();
+		}
+	}
+	if(preview_pending)
+	{
+		app_preview_apply();
+	}
+	if(app_ui_timed_out())
 	{
 		if(current_app_mode != MODE_SHOW_STATE)
 		{
+			app_edit_cancel(); // an unfinished edit is dropped
 			current_app_mode   = MODE_SHOW_STATE;
 			menu_profile_index = current_profile;
 			app_redraw();
 		}
+#if IDLE_BLANK_DISPLAY
+		if(!display_blanked)
+		{
+			ssd1306_poweroff(&disp);
+			display_blanked = true;
+		}
+#endif
 	}
 	if(current_app_mode == MODE_SHOW_STATE)
 	{
-		if(app_calculate_state())
+		uint32_t start	  = time_us_32();
+		bool	 changed  = app_calculate_state();
+		uint32_t state_us = time_us_32() - start;
+		if(state_us > max_state_us)
+		{
+			max_state_us = state_us;
+		}
+		if(changed)
 		{
 			app_apply_state();
 			app_redraw();
+		} else if(alarms_latched() != shown_alarms || thermal_celsius10() / 10 != shown_celsius)
+		{
+			app_redraw();
 		}
 	}
 }
 
+/**
+ * @brief Checks whether the application can sleep until `app_next_update_time()`.
+ *
+ * @return true if the UI timed out and only the schedule is running, false otherwise.
+ */
+bool app_is_idle()
+{
+	return current_app_mode == MODE_SHOW_STATE && app_ui_timed_out();
+}
+
+/**
+ * @brief Returns the time of the next scheduled state change.
+ *
+ * Period transitions and the countdowns on the state screen all change on timebase minute ticks.
+ *
+ * @return The absolute time of the next minute tick.
+ */
+absolute_time_t app_next_update_time()
+{
+	return timebase_next_minute();
+}
+
+/**
+ * @brief Switches a blanked OLED back on.
+ *
+ * The display RAM keeps its contents while the panel is off, and the input that woke it is handled
+ * right away, so the frame it draws is the first one shown.
+ */
+static void app_wake_display()
+{
+	if(!display_blanked)
+	{
+		return;
+	}
+	ssd1306_poweron(&disp);
+	display_blanked = false;
+}
+
 /**
  * @brief Handles encoder input to change and display the current profile.
  *
  * This function updates the currently selected profile based on the encoder's delta value.
- * - If the new profile index is less than 0, it returns to the top menu and redraws the UI.
- * - If the new profile index exceeds the maximum allowed profiles, it wraps around to the first profile.
- * - Updates the menu profile index if it has changed.
- * - Sets the application mode to either show the profile or show the current state, depending on whether
- *   the selected profile matches the current profile.
+ * - Fast turns move by `APP_PROFILE_ACCEL` profiles per detent, see `ui_list_step()`.
+ * - A single detent up from the first profile returns to the top menu and redraws the UI. A single detent
+ *   down from the last profile wraps around to the first profile.
+ * - Larger steps stop at the first or the last profile, so a fast turn never leaves the list.
+ * - Updates the menu profile index and shows the profile browser, or the state screen when the current
+ *   profile is selected.
  * - Triggers a UI redraw after processing.
  *
  * @param delta The change in profile index, typically from encoder input.
  */
 static void app_encoder_show_profile(int delta)
 {
-	int new_profile = menu_profile_index + delta;
+	int step		= ui_list_step(&profile_list, delta);
+	int new_profile = menu_profile_index + step;
 	if(new_profile < 0)
 	{
-		current_app_mode		= MODE_TOP_MENU;
-		current_top_menu_action = TOP_MENU_FIRST;
-		app_redraw();
-		return;
-	}
-	if(new_profile >= MAX_PROFILES)
-	{
-		new_profile = 0;
+		if(step != -1)
+		{
+			new_profile = 0; // fast turn, stop at the first profile
+		} else
+		{
+			current_app_mode		= MODE_TOP_MENU;
+			current_top_menu_action = TOP_MENU_FIRST;
+			app_redraw();
+			return;
+		}
 	}
-
-	if(new_profile != menu_profile_index)
+	if(new_profile >= storage_count())
 	{
-		menu_profile_index = new_profile;
+		new_profile = step != 1 ? storage_count() - 1 : 0; // fast turns stop at the last profile
 	}
 
+	menu_profile_index = new_profile;
 	if(menu_profile_index != current_profile)
 	{
 		current_app_mode = MODE_SHOW_PROFILE;
@@ -997,7 +1501,7 @@ static void app_encoder_show_profile(int delta)
  */
 static void app_encoder_edit_profile(int delta)
 {
-	int new_index = current_edit_period_index + delta;
+	int new_index = current_edit_period_index + ui_list_step(&period_list, delta);
 	if(new_index < -1)
 	{
 		new_index = MAX_PERIODS - 1;
@@ -1016,8 +1520,8 @@ static void app_encoder_edit_profile(int delta)
 /**
  * @brief Adjusts the duration of the currently edited period by a specified delta.
  *
- * This function modifies the duration of the period currently being edited within the
- * active profile. The duration is adjusted in steps of 60 minutes (1 hour) multiplied
+ * This function modifies the duration in `edit_period`, the shadow copy of the period being edited.
+ * The duration is adjusted in steps of 60 minutes (1 hour) multiplied
  * by the given delta. The resulting duration is clamped between 0 and 1440 minutes
  * (24 hours). If the duration changes, the display is updated by calling app_redraw().
  *
@@ -1025,8 +1529,7 @@ static void app_encoder_edit_profile(int delta)
  */
 static void app_encoder_edit_duration(int delta)
 {
-	period_t* period	   = &profiles[current_profile].periods[current_edit_period_index];
-	int		  new_duration = period->duration + delta * 60; // change in 1 hour steps
+	int new_duration = edit_period.duration + delta * 60; // change in 1 hour steps
 	if(new_duration < 0)
 	{
 		new_duration = 0;
@@ -1035,9 +1538,9 @@ static void app_encoder_edit_duration(int delta)
 		new_duration = 24 * 60;
 	}
 
-	if(new_duration != period->duration)
+	if(new_duration != edit_period.duration)
 	{
-		period->duration = new_duration;
+		edit_period.duration = new_duration;
 		app_redraw();
 	}
 }
@@ -1074,16 +1577,15 @@ static void app_encoder_edit_period(int delta)
 /**
  * @brief Adjusts the white-red LED power level for the currently edited period.
  *
- * This function modifies the `led_white_red_power` field of the currently selected period
- * by a delta value (in 5% increments), ensuring the result stays within the 0-100% range.
- * If the power level changes, the display is updated and the new state is applied immediately.
+ * This function modifies the `led_white_red_power` field of `edit_period` by a delta value
+ * (in 5% increments), ensuring the result stays within the 0-100% range. If the power level
+ * changes, the display is updated. The level is previewed on the outputs through `app_preview_apply()`.
  *
  * @param delta The increment or decrement value (multiplied by 5) to adjust the power level.
  */
 static void app_encoder_edit_white_red_level(int delta)
 {
-	period_t* period	= &profiles[current_profile].periods[current_edit_period_index];
-	int		  new_level = period->led_white_red_power + delta * 5; // change in 5% steps
+	int new_level = edit_period.led_white_red_power + delta * 5; // change in 5% steps
 	if(new_level < 0)
 	{
 		new_level = 0;
@@ -1091,13 +1593,13 @@ static void app_encoder_edit_white_red_level(int delta)
 	{
 		new_level = 100;
 	}
-	if(new_level != period->led_white_red_power)
+	if(new_level != edit_period.led_white_red_power)
 	{
-		period->led_white_red_power = new_level;
+		edit_period.led_white_red_power = new_level;
 		app_redraw();
 	}
-	current_app_state.white_red = new_level; // update current state immediately
-	app_apply_state();
+	current_app_state.white_red = new_level; // preview on the outputs
+	app_preview_apply();
 }
 
 /**
@@ -1105,15 +1607,14 @@ static void app_encoder_edit_white_red_level(int delta)
  *
  * This function modifies the blue LED power level by a specified delta,
  * in steps of 5%. The new level is clamped between 0% and 100%. If the
- * level changes, the period's blue power is updated and the UI is redrawn.
- * The current application state is also updated and applied immediately.
+ * level changes, the blue power of `edit_period` is updated and the UI is redrawn.
+ * The level is previewed on the outputs through `app_preview_apply()`.
  *
  * @param delta The amount to change the blue level, in 5% increments.
  */
 static void app_encoder_edit_blue_level(int delta)
 {
-	period_t* period	= &profiles[current_profile].periods[current_edit_period_index];
-	int		  new_level = period->led_blue_power + delta * 5; // change in 5% steps
+	int new_level = edit_period.led_blue_power + delta * 5; // change in 5% steps
 	if(new_level < 0)
 	{
 		new_level = 0;
@@ -1121,13 +1622,328 @@ static void app_encoder_edit_blue_level(int delta)
 	{
 		new_level = 100;
 	}
-	if(new_level != period->led_blue_power)
+	if(new_level != edit_period.led_blue_power)
 	{
-		period->led_blue_power = new_level;
+		edit_period.led_blue_power = new_level;
 		app_redraw();
 	}
-	current_app_state.blue = new_level; // update current state immediately
+	current_app_state.blue = new_level; // preview on the outputs
+	app_preview_apply();
+}
+
+/**
+ * @brief Adjusts the global time shift value by a specified delta.
+ *
+ * This function modifies the global variable `time_shift_hours` by adding the given
+ * `delta` value. The resulting value is clamped within the range [-23, 23]. If the
+ * time shift value changes, the display is redrawn by calling `app_redraw()`.
+ *
+ * @param delta The amount to adjust the time shift, in hours.
+ */
+static void app_encoder_time_shift(int delta)
+{
+	int new_shift = time_shift_hours + delta;
+	if(new_shift < -23)
+	{
+		new_shift = -23;
+	} else if(new_shift > 23)
+	{
+		new_shift = 23;
+	}
+	if(new_shift != time_shift_hours)
+	{
+		time_shift_hours = new_shift;
+		app_redraw();
+	}
+}
+
+/**
+ * @brief Adjusts the edited day of year, wrapping around between 1 and 365.
+ *
+ * @param delta The amount to adjust the day, in days.
+ */
+static void app_encoder_sun_day(int delta)
+{
+	int new_day = (sun_edit_day - 1 + delta) % SOLAR_DAYS;
+	if(new_day < 0)
+	{
+		new_day += SOLAR_DAYS;
+	}
+	sun_edit_day = new_day + 1;
+	app_redraw();
+}
+
+/**
+ * @brief Handles a click on the profile browser: switches to the selected profile and shows the state.
+ */
+static void app_click_show_profile()
+{
+	current_app_mode = MODE_SHOW_STATE;
+	if(menu_profile_index != current_profile)
+	{
+		// Switch to selected profile
+		bool saved = app_switch_profile(menu_profile_index);
+		app_calculate_state();
+		app_apply_state();
+		if(!saved)
+		{
+			app_show_message("SAVE ERROR", MODE_SHOW_STATE);
+		}
+	}
+}
+
+/**
+ * @brief Handles a click on the state screen: enters profile edit mode.
+ */
+static void app_click_show_state()
+{
+	current_edit_period_index = -1;
+	current_app_mode		  = MODE_EDIT_PROFILE;
+}
+
+/**
+ * @brief Handles a click on the "Edit Profile" screen.
+ *
+ * Goes back to the state screen if "BACK" is selected, otherwise opens an edit session on the
+ * selected period, see `app_edit_begin()`.
+ */
+static void app_click_edit_profile()
+{
+	if(current_edit_period_index == -1)
+	{
+		// Back button
+		current_app_mode = MODE_SHOW_STATE;
+	} else
+	{
+		// Edit selected period
+		current_app_mode   = MODE_EDIT_PERIOD;
+		current_edit_value = EDIT_BACK;
+		app_edit_begin();
+	}
+}
+
+/**
+ * @brief Handles a click on the "Edit Period" screen: enters the mode of the selected field.
+ *
+ * "BACK" commits the edit session and returns to the "Edit Profile" screen.
+ */
+static void app_click_edit_period()
+{
+	if(current_edit_value == EDIT_BACK)
+	{
+		app_edit_commit();
+	}
+	current_app_mode = edit_fields[current_edit_value].mode;
+}
+
+/**
+ * @brief Handles a click while a period value is edited: returns to the "Edit Period" screen.
+ */
+static void app_click_edit_value()
+{
+	current_app_mode = MODE_EDIT_PERIOD;
+}
+
+/**
+ * @brief Handles a click on the time shift screen: applies the shift and returns to the top menu.
+ */
+static void app_click_time_shift()
+{
+	current_app_mode = MODE_TOP_MENU;
+	if(time_shift_hours != 0)
+	{
+		app_start_minute += time_shift_hours * 60; // apply time shift
+		app_calculate_state();
+		journal_log(JOURNAL_TIME_SHIFT, time_shift_hours);
+	}
+}
+
+/**
+ * @brief Top menu action: opens the time shift screen.
+ */
+static void app_menu_time_shift()
+{
+	time_shift_hours = 0;
+	current_app_mode = MODE_TIME_SHIFT;
+}
+
+/**
+ * @brief Handles a click on the sun day screen: sets the day of year and returns to the top menu.
+ *
+ * The day counts from now, so a SUN profile is recomputed right away.
+ */
+static void app_click_sun_day()
+{
+	sun_day_of_year	 = sun_edit_day;
+	sun_day_minute	 = timebase_minutes();
+	sun_computed_day = 0; // force recomputation
+	current_app_mode = MODE_TOP_MENU;
+	app_calculate_state();
+	app_apply_state();
+}
+
+/**
+ * @brief Top menu action: opens the sun day screen with the current day of year.
+ */
+static void app_menu_sun_day()
+{
+	sun_edit_day	 = app_day_of_year(timebase_minutes());
+	current_app_mode = MODE_SUN_DAY;
+}
+
+/**
+ * @brief Top menu action: adds a copy of the current profile to the library and switches to it.
+ */
+static void app_menu_copy_profile()
+{
+	profile_t copy = active_profile;
+	snprintf(copy.name, sizeof(copy.name), "RECIPE %d", (storage_count() + 1) % 1000); // at most 3 digits
+	int index = storage_add(&copy);
+	if(index < 0)
+	{
+		app_show_message("LIB FULL", MODE_TOP_MENU);
+		return;
+	}
+	bool saved = app_switch_profile(index);
+	app_calculate_state();
 	app_apply_state();
+	app_show_message(saved ? "COPIED" : "SAVE ERROR", MODE_SHOW_STATE);
+}
+
+/**
+ * @brief Top menu action: opens the diagnostics screen.
+ */
+static void app_menu_diag()
+{
+	diag_top		 = 0;
+	current_app_mode = MODE_DIAG;
+}
+
+/**
+ * @brief Scrolls the diagnostics screen by whole lines, clamped so the screen stays full.
+ */
+static void app_encoder_diag(int delta)
+{
+	int new_top = diag_top + delta;
+	if(new_top > (int) count_of(diag_counters) - APP_DIAG_ROWS)
+	{
+		new_top = (int) count_of(diag_counters) - APP_DIAG_ROWS;
+	}
+	if(new_top < 0)
+	{
+		new_top = 0;
+	}
+	if(new_top != diag_top)
+	{
+		diag_top = new_top;
+		app_redraw();
+	}
+}
+
+/**
+ * @brief Handles a click on the diagnostics screen: returns to the top menu.
+ */
+static void app_click_diag()
+{
+	current_app_mode = MODE_TOP_MENU;
+}
+
+/**
+ * @brief Top menu action: opens the journal screen on the newest event.
+ */
+static void app_menu_journal()
+{
+	journal_index	 = 0;
+	current_app_mode = MODE_JOURNAL;
+}
+
+/**
+ * @brief Scrolls through the journal, clamped to the oldest and newest event.
+ */
+static void app_encoder_journal(int delta)
+{
+	int new_index = journal_index + ui_list_step(&journal_list, delta);
+	if(new_index >= journal_count())
+	{
+		new_index = journal_count() - 1;
+	}
+	if(new_index < 0)
+	{
+		new_index = 0;
+	}
+	if(new_index != journal_index)
+	{
+		journal_index = new_index;
+		app_redraw();
+	}
+}
+
+/**
+ * @brief Handles a click on the journal screen: starts printing the whole journal over USB serial in
+ * the background, see `journal_print()`, and returns to the state screen.
+ */
+static void app_click_journal()
+{
+	journal_print();
+	app_show_message("USB DUMP", MODE_SHOW_STATE);
+}
+
+/**
+ * @brief Top menu action: reloads the profiles from flash with UI feedback.
+ */
+static void app_menu_reload()
+{
+	app_reload_profiles(true);
+}
+
+/**
+ * @brief Top menu action: acknowledges the latched alarms, which also releases a pump lockout.
+ *
+ * Alarms whose condition is still present stay latched.
+ */
+static void app_menu_clear_alarms()
+{
+	alarms_clear();
+	journal_log(JOURNAL_ALARM_CLR, alarms_active());
+	app_show_message("CLEARED", MODE_SHOW_STATE);
+}
+
+static const app_menu_item_t top_menu_items[TOP_MENU_COUNT] = {
+#define TOP_MENU_ENTRY(action_id, item_label, handler) [action_id] = {.label = item_label, .action = handler},
+	TOP_MENU_ITEMS(TOP_MENU_ENTRY)
+#undef TOP_MENU_ENTRY
+};
+
+/**
+ * @brief Draws the top menu on the SSD1306 display.
+ *
+ * This function clears the display and draws the items listed in `TOP_MENU_ITEMS`, highlighting
+ * the currently selected one (`current_top_menu_action`) with a '>' indicator. When there are more
+ * items than fit on the screen, the list scrolls to keep the selection visible.
+ */
+static void app_draw_top_menu()
+{
+	int y		  = 0;
+	int x		  = 11;
+	int top_index = current_top_menu_action - (APP_MENU_ROWS - 1);
+	if(top_index < 0)
+	{
+		top_index = 0;
+	}
+
+	ssd1306_clear(&disp);
+
+	for(int i = top_index; i < TOP_MENU_COUNT && i < top_index + APP_MENU_ROWS; i++)
+	{
+		if(i == current_top_menu_action)
+		{
+			ssd1306_draw_string(&disp, 0, y, 2, ">"); // indicate selected action
+		}
+		ssd1306_draw_string(&disp, x, y, 2, top_menu_items[i].label);
+		y += 16;
+	}
+
+	ssd1306_show(&disp);
 }
 
 /**
@@ -1168,37 +1984,41 @@ static void app_encoder_top_menu(int delta)
 }
 
 /**
- * @brief Adjusts the global time shift value by a specified delta.
- *
- * This function modifies the global variable `time_shift_hours` by adding the given
- * `delta` value. The resulting value is clamped within the range [-23, 23]. If the
- * time shift value changes, the display is redrawn by calling `app_redraw()`.
+ * @brief Handles a click on the top menu: runs the selected item's action.
+ */
+static void app_click_top_menu()
+{
+	top_menu_items[current_top_menu_action].action();
+}
+
+static const app_mode_handlers_t app_modes[MODE_COUNT] = {
+#define APP_MODE_ENTRY(mode, encoder_handler, click_handler, draw_handler) \
+	[mode] = {.on_encoder = encoder_handler, .on_click = click_handler, .draw = draw_handler},
+	APP_MODES(APP_MODE_ENTRY)
+#undef APP_MODE_ENTRY
+};
+
+/**
+ * @brief Redraws the application UI based on the current application mode.
  *
- * @param delta The amount to adjust the time shift, in hours.
+ * Dispatches to the draw handler of `current_app_mode` in `app_modes[]`.
+ * The system clock is boosted to the active point for the redraw burst.
  */
-static void app_encoder_time_shift(int delta)
+static void app_redraw()
 {
-	int new_shift = time_shift_hours + delta;
-	if(new_shift < -23)
-	{
-		new_shift = -23;
-	} else if(new_shift > 23)
-	{
-		new_shift = 23;
-	}
-	if(new_shift != time_shift_hours)
-	{
-		time_shift_hours = new_shift;
-		app_redraw();
-	}
+	power_boost();
+	frame_drawn = true;
+
+	app_modes[current_app_mode].draw();
 }
 
 /**
  * @brief Handles changes in the encoder input and dispatches actions based on the current application mode.
  *
  * This function is called whenever the encoder value changes. It updates the timestamp of the last encoder event,
- * and then, depending on the current application mode, delegates the handling of the encoder change to the appropriate
- * function. If the delta is zero, the function returns immediately without taking any action.
+ * and then delegates the handling of the encoder change to the handler of the current mode in `app_modes[]`.
+ * If the delta is zero, the function returns immediately without taking any action.
+ * If the display was blanked while idle, it is switched back on and the change is handled as usual.
  *
  * @param delta The change in encoder value. If zero, no action is taken.
  */
@@ -1210,153 +2030,52 @@ void app_on_encoder_change(int delta)
 	}
 
 	last_encoder_time = get_absolute_time();
+	power_boost();
+	app_wake_display();
 
-	switch(current_app_mode)
-	{
-	case MODE_SHOW_PROFILE:
-	case MODE_SHOW_STATE:
-		app_encoder_show_profile(delta);
-		break;
-	case MODE_EDIT_PROFILE:
-		app_encoder_edit_profile(delta);
-		break;
-	case MODE_EDIT_PERIOD:
-		app_encoder_edit_period(delta);
-		break;
-	case MODE_EDIT_DURATION:
-		app_encoder_edit_duration(delta);
-		break;
-	case MODE_EDIT_WR_LEVEL:
-		app_encoder_edit_white_red_level(delta);
-		break;
-	case MODE_EDIT_BL_LEVEL:
-		app_encoder_edit_blue_level(delta);
-		break;
-	case MODE_TOP_MENU:
-		app_encoder_top_menu(delta);
-		break;
-	case MODE_TIME_SHIFT:
-		app_encoder_time_shift(delta);
-		break;
-	default:
-		break;
-	}
+	app_modes[current_app_mode].on_encoder(delta);
 }
 
 /**
  * @brief Handles the main click event in the application, performing actions based on the current application mode.
  *
- * This function is called when a click event occurs (e.g., button press or encoder click).
- * It updates the application state and transitions between different modes such as profile selection,
- * profile editing, period editing, and top menu actions. Depending on the current mode and context,
- * it may switch profiles, enter edit modes, apply state changes, save or reload profiles, shift time,
- * or reboot to bootloader. After handling the event, it triggers a redraw of the application UI.
- *
- * The function uses several global variables to track the current mode, selected profile, edit indices,
- * and application state.
+ * This function is called when the button is released before a long press, see `INPUT_EVENT_CLICK`.
+ * It dispatches to the click handler of the current mode in `app_modes[]`, which may switch profiles,
+ * enter edit modes, apply state changes, or run a top menu action. After handling the event,
+ * it redraws the application UI, unless the handler already drew a frame (a status message, for
+ * example). If the display was blanked while idle, it is switched back on first.
  */
 void app_on_click()
 {
 	last_encoder_time = get_absolute_time();
+	power_boost();
+	app_wake_display();
 
-	switch(current_app_mode)
+	frame_drawn = false;
+	app_modes[current_app_mode].on_click();
+	if(!frame_drawn)
 	{
-	case MODE_SHOW_PROFILE:
-		if(menu_profile_index != current_profile)
-		{
-			// Switch to selected profile
-			current_profile	 = menu_profile_index;
-			current_app_mode = MODE_SHOW_STATE;
-			app_calculate_state();
-			app_apply_state();
-		}
-		break;
-	case MODE_SHOW_STATE:
-		{
-			// Enter profile edit mode
-			current_edit_period_index = -1;
-			current_app_mode		  = MODE_EDIT_PROFILE;
-		}
-		break;
-	case MODE_EDIT_PROFILE:
-		{
-			if(current_edit_period_index == -1)
-			{
-				// Back button
-				current_app_mode = MODE_SHOW_STATE;
-			} else
-			{
-				// Edit selected period
-				current_app_mode			= MODE_EDIT_PERIOD;
-				current_edit_value			= EDIT_BACK;
-				profile_t* profile			= &profiles[current_profile];
-				period_t*  period			= &profile->periods[current_edit_period_index];
-				current_app_state.white_red = period->led_white_red_power; // update current state immediately
-				current_app_state.blue		= period->led_blue_power;	   // update current state immediately
-				app_apply_state();
-			}
-		}
-		break;
-	case MODE_EDIT_PERIOD:
-		{
-			switch(current_edit_value)
-			{
-			case EDIT_BACK:
-				current_app_mode = MODE_EDIT_PROFILE;
-				break;
-			case EDIT_WR_LEVEL:
-				current_app_mode = MODE_EDIT_WR_LEVEL;
-				break;
-			case EDIT_BL_LEVEL:
-				current_app_mode = MODE_EDIT_BL_LEVEL;
-				break;
-			case EDIT_DURATION:
-				current_app_mode = MODE_EDIT_DURATION;
-				break;
-			default:
-				break;
-			}
-		}
-		break;
-	case MODE_EDIT_DURATION:
-	case MODE_EDIT_WR_LEVEL:
-	case MODE_EDIT_BL_LEVEL:
-		current_app_mode = MODE_EDIT_PERIOD;
-		break;
-	case MODE_TOP_MENU:
-		{
-			switch(current_top_menu_action)
-			{
-			case TOP_MENU_SAVE:
-				app_save_profiles();
-				break;
-			case TOP_MENU_RELOAD:
-				app_reload_profiles(true);
-				break;
-			case TOP_MENU_FLASH:
-				app_reboot_to_bootloader();
-				break;
-			case TOP_MENU_SHIFT:
-				time_shift_hours = 0;
-				current_app_mode = MODE_TIME_SHIFT;
-				break;
-			default:
-				break;
-			}
-		}
-		break;
-	case MODE_TIME_SHIFT:
-		// Not implemented yet
-		current_app_mode = MODE_TOP_MENU;
-		if(time_shift_hours != 0)
-		{
-			app_start_time += (uint64_t) (time_shift_hours) * 60L * 60L * 1000L * 1000L; // apply time shift
-			app_calculate_state();
-		}
-		break;
-	default:
-		break;
+		app_redraw();
 	}
+}
 
-	app_redraw();
+/**
+ * @brief Handles a long press of the encoder button: cancels an open edit session and returns to the
+ * "Edit Profile" screen with the period unchanged.
+ *
+ * A press is reported either as a click on release or as a long press, never both, so the press that
+ * cancels has not committed the session ("BACK") or opened a new one before. Outside an edit session a
+ * long press only wakes the display.
+ */
+void app_on_long_press()
+{
+	last_encoder_time = get_absolute_time();
+	power_boost();
+	app_wake_display();
+	if(!edit_open)
+	{
+		return;
+	}
+	app_edit_cancel();
+	app_show_message("CANCELLED", MODE_EDIT_PROFILE);
 }
@@ -1,9 +1,14 @@
 #ifndef APP_H
 #define APP_H
 
+#include "pico/stdlib.h"
+
 extern void app_init();
 extern void app_on_encoder_change(int delta);
 extern void app_tick();
 extern void app_on_click();
+extern void app_on_long_press();
+extern bool app_is_idle();
+extern absolute_time_t app_next_update_time();
 
 #endif // APP_H
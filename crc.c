@@ -0,0 +1,88 @@
+#include "pico/stdlib.h"
+#if PICO_ON_DEVICE
+#include "hardware/dma.h"
+#endif
+#include "crc.h"
+
+#define CRC32_POLY 0x04C11DB7 // IEEE 802.3 polynomial, processed MSB first like the DMA sniffer
+
+#if PICO_ON_DEVICE
+static int		 dma_chan = -1; // channel streaming data through the sniffer, -1 if none could be claimed
+static uint32_t dma_sink;		// write target of the checksum transfers, never incremented
+#endif
+
+/**
+ * @brief Claims the DMA channel used to compute checksums.
+ *
+ * Without a free channel `crc32()` silently falls back to the software loop.
+ */
+void crc_init()
+{
+#if PICO_ON_DEVICE
+	dma_chan = dma_claim_unused_channel(false);
+#endif
+}
+
+/**
+ * @brief Computes the CRC-32 in software: polynomial 0x04C11DB7, MSB first, initial value 0xFFFFFFFF,
+ * no final xor. Gives the same result as the DMA sniffer in CRC-32 mode.
+ *
+ * @param data The data.
+ * @param size Length of the data in bytes.
+ * @return The CRC.
+ */
+uint32_t crc32_software(const void* data, uint32_t size)
+{
+	const uint8_t* bytes = data;
+	uint32_t	   crc	 = CRC32_INIT;
+	for(uint32_t i = 0; i < size; i++)
+	{
+		crc ^= (uint32_t) bytes[i] << 24;
+		for(int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80000000) ? (crc << 1) ^ CRC32_POLY : crc << 1;
+		}
+	}
+	return crc;
+}
+
+/**
+ * @brief Computes the CRC-32 of a block of RAM or XIP flash, see `crc32_software()` for the parameters.
+ *
+ * On the device the data is streamed by a DMA memory-to-null transfer with the sniffer enabled, so
+ * the checksum runs at bus speed without a CPU loop. Word aligned blocks are read a word at a time
+ * with the sniffer byte swap on, which feeds the bytes in memory order just like byte transfers.
+ * Host builds, and device builds without a free DMA channel, use `crc32_software()`.
+ *
+ * @param data The data.
+ * @param size Length of the data in bytes.
+ * @return The CRC.
+ */
+uint32_t crc32(const void* data, uint32_t size)
+{
+#if PICO_ON_DEVICE
+	if(dma_chan < 0 || size == 0)
+	{
+		return crc32_software(data, size);
+	}
+
+	bool words = ((uintptr_t) data & 3) == 0 && (size & 3) == 0;
+
+	dma_channel_config config = dma_channel_get_default_config(dma_chan);
+	channel_config_set_transfer_data_size(&config, words ? DMA_SIZE_32 : DMA_SIZE_8);
+	channel_config_set_read_increment(&config, true);
+	channel_config_set_write_increment(&config, false);
+	channel_config_set_sniff_enable(&config, true);
+
+	dma_sniffer_set_data_accumulator(CRC32_INIT);
+	dma_sniffer_set_byte_swap_enabled(words);
+	dma_sniffer_enable(dma_chan, DMA_SNIFF_CTRL_CALC_VALUE_CRC32, true);
+	dma_channel_configure(dma_chan, &config, &dma_sink, data, words ? size / 4 : size, true);
+	dma_channel_wait_for_finish_blocking(dma_chan);
+	uint32_t crc = dma_sniffer_get_data_accumulator();
+	dma_sniffer_disable();
+	return crc;
+#else
+	return crc32_software(data, size);
+#endif
+}
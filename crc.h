@@ -0,0 +1,12 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include "pico/stdlib.h"
+
+#define CRC32_INIT 0xFFFFFFFF // initial value of `crc32()`
+
+extern void		crc_init();
+extern uint32_t crc32(const void* data, uint32_t size);
+extern uint32_t crc32_software(const void* data, uint32_t size);
+
+#endif // CRC_H
@@ -0,0 +1,206 @@
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/sync.h"
+#include "quadrature_encoder.pio.h"
+#include "pins.h"
+#include "power.h"
+#include "input.h"
+
+#define ENCODER_PIO pio0
+#define ENCODER_SM	0
+
+static input_event_t	 queue[INPUT_QUEUE_SIZE];
+static volatile uint32_t queue_head		= 0; // next slot to write, only changed from IRQ context
+static volatile uint32_t queue_tail		= 0; // next slot to read, only changed by the consumer
+static uint32_t			 dropped		= 0; // events lost because the queue was full
+static uint32_t			 max_latency_us = 0; // worst delay between an edge and its event being consumed
+
+static int32_t encoder_detents = 0; // last reported encoder position in detents
+
+static bool		button_pressed	 = false; // debounced button state
+static uint32_t button_edge_us	 = 0;	  // time of the last button edge
+static uint32_t button_burst_us	 = 0;	  // time of the first edge of the current bounce burst
+static bool		debounce_pending = false; // debounce alarm scheduled
+static uint32_t press_count		 = 0;	  // incremented on every press, identifies the press a long-press alarm belongs to
+static bool		long_pressed	 = false; // the current press has reported a long press
+
+/**
+ * @brief Appends an event to the queue and wakes the main loop. IRQ context only.
+ *
+ * The queue is single-producer/single-consumer: the GPIO and timer IRQs that produce events run at
+ * the same priority and never preempt each other, so no lock is needed.
+ */
+static void input_push(input_event_type_t type, int delta, uint32_t time_us)
+{
+	uint32_t head = queue_head;
+	if(head - queue_tail >= INPUT_QUEUE_SIZE)
+	{
+		dropped++;
+		return;
+	}
+	input_event_t* event = &queue[head & (INPUT_QUEUE_SIZE - 1)];
+	event->type			 = type;
+	event->delta		 = delta;
+	event->time_us		 = time_us;
+	__dmb();
+	queue_head = head + 1;
+
+	power_wake();
+}
+
+/**
+ * @brief Long-press alarm, fires `INPUT_LONG_PRESS_MS` after a press.
+ */
+static int64_t input_on_long_press(alarm_id_t id, void* user_data)
+{
+	if(button_pressed && press_count == (uint32_t) (uintptr_t) user_data)
+	{
+		long_pressed = true;
+		input_push(INPUT_EVENT_LONG_PRESS, 0, time_us_32());
+	}
+	return 0;
+}
+
+/**
+ * @brief Debounce alarm for the button.
+ *
+ * Re-arms itself until the button has been stable for `INPUT_DEBOUNCE_MS`, then reports a press or
+ * release stamped with the first edge of the bounce burst. A release that ends a press before its long
+ * press also reports a click.
+ */
+static int64_t input_on_debounce(alarm_id_t id, void* user_data)
+{
+	uint32_t stable_us = time_us_32() - button_edge_us;
+	if(stable_us < INPUT_DEBOUNCE_MS * 1000)
+	{
+		return INPUT_DEBOUNCE_MS * 1000 - stable_us; // positive: reschedule relative to now
+	}
+	debounce_pending = false;
+
+	bool pressed	 = !gpio_get(PIN_BUTTON); // active low
+	if(pressed != button_pressed)
+	{
+		button_pressed = pressed;
+		if(pressed)
+		{
+			press_count++;
+			long_pressed = false;
+			input_push(INPUT_EVENT_PRESS, 0, button_burst_us);
+			add_alarm_in_ms(INPUT_LONG_PRESS_MS, input_on_long_press, (void*) (uintptr_t) press_count, true);
+		} else
+		{
+			input_push(INPUT_EVENT_RELEASE, 0, button_burst_us);
+			if(!long_pressed)
+			{
+				input_push(INPUT_EVENT_CLICK, 0, button_burst_us);
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief GPIO edge interrupt for the encoder and the button.
+ *
+ * Encoder edges read the PIO counter and report whole detents. Button edges (re)start the debounce.
+ */
+static void input_on_gpio_edge(uint gpio, uint32_t events)
+{
+	uint32_t now = time_us_32();
+
+	if(gpio == PIN_BUTTON)
+	{
+		button_edge_us = now;
+		if(!debounce_pending)
+		{
+			debounce_pending = true;
+			button_burst_us	 = now;
+			if(add_alarm_in_ms(INPUT_DEBOUNCE_MS, input_on_debounce, NULL, true) < 0)
+			{
+				debounce_pending = false; // no alarm slot, the next edge tries again
+			}
+		}
+		return;
+	}
+
+	int32_t detents = quadrature_encoder_get_count(ENCODER_PIO, ENCODER_SM) / 4;
+	if(detents != encoder_detents)
+	{
+		input_push(INPUT_EVENT_DETENT, encoder_detents - detents, now); // counter runs counter-clockwise
+		encoder_detents = detents;
+	}
+}
+
+/**
+ * @brief Initializes the encoder, the button and their edge interrupts.
+ */
+void input_init()
+{
+	gpio_init(PIN_BUTTON);
+	gpio_set_dir(PIN_BUTTON, GPIO_IN);
+	gpio_pull_up(PIN_BUTTON);
+
+	// The B phase of the encoder must be connected to the pin after PIN_ENCODER_A
+	pio_add_program(ENCODER_PIO, &quadrature_encoder_program);
+	quadrature_encoder_program_init(ENCODER_PIO, ENCODER_SM, PIN_ENCODER_A, 0);
+	encoder_detents = quadrature_encoder_get_count(ENCODER_PIO, ENCODER_SM) / 4;
+
+	gpio_set_irq_enabled_with_callback(PIN_BUTTON, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, input_on_gpio_edge);
+	gpio_set_irq_enabled(PIN_ENCODER_A, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+	gpio_set_irq_enabled(PIN_ENCODER_B, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+}
+
+/**
+ * @brief Takes the next event from the queue.
+ *
+ * Consecutive detent events are coalesced into one, carrying the summed delta and the timestamp
+ * of the first one.
+ *
+ * @param event Receives the event.
+ * @return true if an event was returned, false if the queue is empty.
+ */
+bool input_get_event(input_event_t* event)
+{
+	uint32_t tail = queue_tail;
+	if(tail == queue_head)
+	{
+		return false;
+	}
+	__dmb();
+	*event = queue[tail & (INPUT_QUEUE_SIZE - 1)];
+	tail++;
+
+	if(event->type == INPUT_EVENT_DETENT)
+	{
+		while(tail != queue_head && queue[tail & (INPUT_QUEUE_SIZE - 1)].type == INPUT_EVENT_DETENT)
+		{
+			event->delta += queue[tail & (INPUT_QUEUE_SIZE - 1)].delta;
+			tail++;
+		}
+	}
+	queue_tail		 = tail;
+
+	uint32_t latency = time_us_32() - event->time_us;
+	if(latency > max_latency_us)
+	{
+		max_latency_us = latency;
+	}
+	return true;
+}
+
+/**
+ * @brief Returns the number of events dropped because the queue was full.
+ */
+uint32_t input_dropped_events()
+{
+	return dropped;
+}
+
+/**
+ * @brief Returns the worst observed delay between an input edge and its event being consumed, in microseconds.
+ */
+uint32_t input_max_latency_us()
+{
+	return max_latency_us;
+}
@@ -0,0 +1,53 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "pico/stdlib.h"
+
+#define INPUT_QUEUE_SIZE	32	 // event queue length, must be a power of two
+#define INPUT_DEBOUNCE_MS	50	 // button must be stable this long before a press/release is reported
+#define INPUT_LONG_PRESS_MS 1000 // button held this long reports a long press
+
+/**
+ * @enum input_event_type_t
+ * @brief Kinds of input events.
+ *
+ * - INPUT_EVENT_DETENT:     The encoder moved by `delta` detents (positive = clockwise).
+ * - INPUT_EVENT_PRESS:      The button was pressed (debounced).
+ * - INPUT_EVENT_RELEASE:    The button was released (debounced).
+ * - INPUT_EVENT_LONG_PRESS: The button has been held for `INPUT_LONG_PRESS_MS`.
+ * - INPUT_EVENT_CLICK:      The button was released before a long press, right after INPUT_EVENT_RELEASE.
+ *                           A press reports either a click or a long press, never both.
+ */
+typedef enum
+{
+	INPUT_EVENT_DETENT,
+	INPUT_EVENT_PRESS,
+	INPUT_EVENT_RELEASE,
+	INPUT_EVENT_LONG_PRESS,
+	INPUT_EVENT_CLICK,
+} input_event_type_t;
+
+/**
+ * @struct input_event_t
+ * @brief A timestamped input event.
+ *
+ * @var input_event_t::type
+ *   The kind of event.
+ * @var input_event_t::delta
+ *   Detents moved, only for INPUT_EVENT_DETENT.
+ * @var input_event_t::time_us
+ *   Time of the first edge that caused the event (low 32 bits of the microsecond timer).
+ */
+typedef struct
+{
+	uint8_t	 type;
+	int16_t	 delta;
+	uint32_t time_us;
+} input_event_t;
+
+extern void		input_init();
+extern bool		input_get_event(input_event_t* event);
+extern uint32_t input_dropped_events();
+extern uint32_t input_max_latency_us();
+
+#endif // INPUT_H
@@ -0,0 +1,352 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "task.h"
+#include "journal.h"
+
+static_assert(sizeof(journal_event_t) == 8, "journal_event_t is a flash record, its size must not change by accident");
+static_assert(FLASH_PAGE_SIZE % sizeof(journal_event_t) == 0, "journal events must not straddle a page");
+static_assert(JOURNAL_SECTORS >= 2, "the sector ahead of the newest event is kept erased");
+
+#define JOURNAL_PAGE_SLOTS	 (FLASH_PAGE_SIZE / sizeof(journal_event_t))   // events per program page
+#define JOURNAL_SECTOR_SLOTS (FLASH_SECTOR_SIZE / sizeof(journal_event_t)) // events per sector
+#define JOURNAL_SLOTS		 (JOURNAL_SECTORS * JOURNAL_SECTOR_SLOTS)	   // events the journal can hold
+#define JOURNAL_ERASED		 0xFF										   // `type` of an erased slot
+
+static const char* const journal_labels[JOURNAL_EVENT_COUNT] = {
+#define JOURNAL_LABEL(event, label) [event] = label,
+	JOURNAL_EVENTS(JOURNAL_LABEL)
+#undef JOURNAL_LABEL
+};
+
+static journal_event_t page[JOURNAL_PAGE_SLOTS];   // RAM image of the page being filled
+static journal_event_t queued[JOURNAL_PAGE_SLOTS]; // full page holding `head`, waiting for the flush task
+static bool			   page_queued	= false;	   // `queued` holds a page
+static bool			   ahead_erased = false;	   // the sector after the queued page has been erased
+static int			   head			= 0;		   // next free slot in flash
+static int			   staged		= 0;		   // events from slot `head` on, not written yet
+static int			   stored		= 0;		   // events in flash
+static uint8_t		   boot			= 0;		   // number of this boot
+static uint32_t		   logged		= 0;		   // events logged since boot
+static absolute_time_t flush_due;				   // the staged events are written by then
+static task_t		   flush_task;				   // writes the queued page and the staged events
+
+static task_t	print_task;		  // prints the journal `JOURNAL_PRINT_LINES` events per step
+static int		print_left	 = 0; // events still to print, the next one is `print_left` - 1 events older
+static uint32_t print_logged = 0; // `logged` when `print_left` was counted
+
+/**
+ * @brief Returns a journal slot, read in place from flash.
+ */
+static const journal_event_t* journal_slot(int slot)
+{
+	return (const journal_event_t*) (XIP_BASE + JOURNAL_OFFSET + slot * sizeof(journal_event_t));
+}
+
+/**
+ * @brief Checks whether a slot is erased. Slots wrap around at `JOURNAL_SLOTS`.
+ */
+static bool journal_erased(int slot)
+{
+	return journal_slot((slot + JOURNAL_SLOTS) % JOURNAL_SLOTS)->type == JOURNAL_ERASED;
+}
+
+/**
+ * @brief Erases the sector holding a slot.
+ */
+static void journal_erase_sector(int slot)
+{
+	uint32_t ints = save_and_disable_interrupts();
+	flash_range_erase(JOURNAL_OFFSET + (slot - slot % JOURNAL_SECTOR_SLOTS) * sizeof(journal_event_t),
+					  FLASH_SECTOR_SIZE);
+	restore_interrupts(ints);
+}
+
+/**
+ * @brief Returns the RAM copy of a staged slot: in `queued` if it is in the queued page, else in `page`.
+ */
+static journal_event_t* journal_staged_slot(int slot)
+{
+	bool in_queued = page_queued && slot / JOURNAL_PAGE_SLOTS == head / JOURNAL_PAGE_SLOTS;
+	return in_queued ? &queued[slot % JOURNAL_PAGE_SLOTS] : &page[slot % JOURNAL_PAGE_SLOTS];
+}
+
+/**
+ * @brief Programs the page holding `head` from a RAM image and moves `head` past its `count` staged events.
+ *
+ * The earlier events of the page are programmed again unchanged, which NOR flash allows without an erase.
+ */
+static void journal_program(const journal_event_t* image, int count)
+{
+	uint32_t ints = save_and_disable_interrupts();
+	flash_range_program(JOURNAL_OFFSET + (head - head % JOURNAL_PAGE_SLOTS) * sizeof(journal_event_t),
+						(const uint8_t*) image, FLASH_PAGE_SIZE);
+	restore_interrupts(ints);
+
+	head	= (head + count) % JOURNAL_SLOTS;
+	stored += count;
+	staged -= count;
+}
+
+/**
+ * @brief Moves `page` to `queued` once it is full and signals the flush task. Nothing happens while a page
+ * is queued already.
+ */
+static void journal_queue_page()
+{
+	if(page_queued || head % JOURNAL_PAGE_SLOTS + staged < JOURNAL_PAGE_SLOTS)
+	{
+		return;
+	}
+	memcpy(queued, page, sizeof(queued));
+	memset(page, JOURNAL_ERASED, sizeof(page));
+	page_queued	 = true;
+	ahead_erased = false;
+	task_signal(JOURNAL_EVENT_PAGE);
+}
+
+/**
+ * @brief Checks whether the queued page is the last of its sector and the next sector still has to be
+ * erased before it is written.
+ */
+static bool journal_erase_due()
+{
+	int next_page = head - head % JOURNAL_PAGE_SLOTS + JOURNAL_PAGE_SLOTS;
+	return page_queued && !ahead_erased && next_page % JOURNAL_SECTOR_SLOTS == 0;
+}
+
+/**
+ * @brief Erases the sector after the one holding `head`. Its events, the oldest of the journal, are dropped.
+ */
+static void journal_erase_ahead()
+{
+	journal_erase_sector((head - head % JOURNAL_SECTOR_SLOTS + JOURNAL_SECTOR_SLOTS) % JOURNAL_SLOTS);
+	stored		 = MIN(stored, JOURNAL_SLOTS - 2 * JOURNAL_SECTOR_SLOTS + head % JOURNAL_SECTOR_SLOTS);
+	ahead_erased = true;
+}
+
+/**
+ * @brief Programs the queued page, then queues `page` if it filled up meanwhile.
+ */
+static void journal_write_queued()
+{
+	page_queued = false;
+	journal_program(queued, JOURNAL_PAGE_SLOTS - head % JOURNAL_PAGE_SLOTS);
+	journal_queue_page();
+}
+
+/**
+ * @brief Task that writes the journal to flash, one flash operation per step.
+ *
+ * A queued page is written as soon as `journal_log()` signals it. The sector after it is erased in a step
+ * of its own before the last page of a sector is written, so the sector ahead of the newest event is
+ * erased at all times. Events of a page that is not full yet are written at `flush_due`.
+ */
+static task_status_t journal_flush_task_fn(task_t* task)
+{
+	TASK_BEGIN(task);
+	while(staged > 0)
+	{
+		if(!page_queued)
+		{
+			TASK_WAIT_EVENT_UNTIL(task, JOURNAL_EVENT_PAGE, flush_due);
+		}
+		if(journal_erase_due())
+		{
+			journal_erase_ahead();
+			TASK_YIELD(task);
+		}
+		if(page_queued)
+		{
+			journal_write_queued();
+		} else if(staged > 0)
+		{
+			journal_program(page, staged); // flush_due reached
+		}
+		TASK_YIELD(task);
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Finds the end of the journal in flash and logs JOURNAL_BOOT.
+ *
+ * The journal is a ring of event slots. The sector after the newest event is always erased, so the
+ * newest event is the written slot right before the only erased slot that follows a written one.
+ * The boot number continues from that event.
+ */
+void journal_init()
+{
+	head = 0;
+	for(int slot = 0; slot < JOURNAL_SLOTS; slot++)
+	{
+		if(journal_erased(slot) && !journal_erased(slot - 1))
+		{
+			head = slot;
+			break;
+		}
+	}
+	if(!journal_erased(head))
+	{
+		// No erased slot at all, the region held something else. None of it is an event.
+		for(int slot = 0; slot < JOURNAL_SLOTS; slot += JOURNAL_SECTOR_SLOTS)
+		{
+			journal_erase_sector(slot);
+		}
+	}
+
+	stored = 0;
+	while(stored < JOURNAL_SLOTS && !journal_erased(head - 1 - stored))
+	{
+		stored++;
+	}
+	boot = stored > 0 ? journal_slot((head + JOURNAL_SLOTS - 1) % JOURNAL_SLOTS)->boot + 1 : 0;
+
+	memcpy(page, journal_slot(head - head % JOURNAL_PAGE_SLOTS), sizeof(page));
+	staged		= 0;
+	page_queued = false;
+	task_stop(&flush_task);
+
+	journal_log(JOURNAL_BOOT, boot);
+}
+
+/**
+ * @brief Logs an event.
+ *
+ * The event is staged in RAM and never written here: a full page of events is queued for the flush task,
+ * which programs it on the next main loop pass, and a page that is not full is written `JOURNAL_FLUSH_MS`
+ * after its first event. Single events therefore never cost an erase, and callers never wait for flash.
+ * If a second page fills before the flush task wrote the first, further events are dropped until it has.
+ * Not safe to call from IRQ context.
+ *
+ * @param type The event.
+ * @param arg  Event argument, see `JOURNAL_EVENTS`.
+ */
+void journal_log(journal_event_id_t type, int arg)
+{
+	if(staged >= 2 * JOURNAL_PAGE_SLOTS - head % JOURNAL_PAGE_SLOTS)
+	{
+		return; // the queued page and `page` are both full
+	}
+	if(staged == 0)
+	{
+		flush_due = make_timeout_time_ms(JOURNAL_FLUSH_MS);
+	}
+	*journal_staged_slot(head + staged) = (journal_event_t) {
+		.seconds = to_ms_since_boot(get_absolute_time()) / 1000,
+		.type	 = type,
+		.boot	 = boot,
+		.arg	 = arg,
+	};
+	staged++;
+	logged++;
+
+	journal_queue_page();
+	if(!task_is_running(&flush_task))
+	{
+		task_start(&flush_task, journal_flush_task_fn);
+	}
+}
+
+/**
+ * @brief Writes the queued page and the staged events to flash right away, erasing the sector ahead as the
+ * flush task would. Blocks for the flash operations, for use right before a reboot.
+ */
+void journal_flush()
+{
+	while(page_queued)
+	{
+		if(journal_erase_due())
+		{
+			journal_erase_ahead();
+		}
+		journal_write_queued();
+	}
+	if(staged > 0)
+	{
+		journal_program(page, staged);
+	}
+}
+
+/**
+ * @brief Returns the number of events in the journal, staged ones included.
+ */
+int journal_count()
+{
+	return stored + staged;
+}
+
+/**
+ * @brief Reads an event.
+ *
+ * @param age   0 for the newest event, up to `journal_count()` - 1 for the oldest.
+ * @param event Receives the event.
+ * @return false if there is no such event.
+ */
+bool journal_read(int age, journal_event_t* event)
+{
+	if(age < 0 || age >= stored + staged)
+	{
+		return false;
+	}
+	if(age < staged)
+	{
+		*event = *journal_staged_slot(head + staged - 1 - age);
+	} else
+	{
+		memcpy(event, journal_slot((head + JOURNAL_SLOTS - 1 - (age - staged)) % JOURNAL_SLOTS), sizeof(*event));
+	}
+	return true;
+}
+
+/**
+ * @brief Returns the label of an event type, "?" for types this firmware does not know.
+ */
+const char* journal_label(int type)
+{
+	return type >= 0 && type < JOURNAL_EVENT_COUNT ? journal_labels[type] : "?";
+}
+
+/**
+ * @brief Task that prints the journal, `JOURNAL_PRINT_LINES` events per step.
+ *
+ * Events logged during the dump make the remaining ones older by as many; those dropped meanwhile
+ * because the journal wrapped are skipped.
+ */
+static task_status_t journal_print_task_fn(task_t* task)
+{
+	TASK_BEGIN(task);
+	printf("JOURNAL %d EVENTS\n", print_left);
+	while(print_left > 0)
+	{
+		for(int line = 0; line < JOURNAL_PRINT_LINES && print_left > 0; line++)
+		{
+			journal_event_t event;
+			print_left--;
+			if(journal_read(print_left + (int) (logged - print_logged), &event))
+			{
+				printf("%3u %8lu %-8s %d\n", event.boot, (unsigned long) event.seconds, journal_label(event.type),
+					   event.arg);
+			}
+		}
+		TASK_YIELD(task);
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Prints the journal to stdio (USB serial), oldest event first, one line per event:
+ * boot number, seconds since that boot, label and argument.
+ *
+ * Returns at once. The events are printed by a task a few per main loop pass, so a slow or stalled
+ * USB host never holds up the UI. A print already running starts over.
+ */
+void journal_print()
+{
+	print_left	 = journal_count();
+	print_logged = logged;
+	task_start(&print_task, journal_print_task_fn);
+}
@@ -0,0 +1,74 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "storage.h"
+
+#define JOURNAL_SECTORS		4		  // flash sectors of the journal, the oldest sector is erased when it wraps
+#define JOURNAL_FLUSH_MS	60000	  // staged events are written at most this long after they were logged
+#define JOURNAL_PRINT_LINES	8		  // events `journal_print()` writes to stdio per main loop pass
+#define JOURNAL_EVENT_PAGE	(1u << 1) // task event signalled when a full page of events is queued for flash
+
+#define JOURNAL_OFFSET (STORAGE_BASE_OFFSET - JOURNAL_SECTORS * FLASH_SECTOR_SIZE) // right below the library
+
+/**
+ * @brief Journal events: X(event, label). The argument of each event is noted after it.
+ *
+ * - JOURNAL_BOOT:       Firmware started, boot number.
+ * - JOURNAL_PROFILE:    Profile switched, new profile index.
+ * - JOURNAL_SAVE:       Profile saved from the menu, profile index.
+ * - JOURNAL_SAVE_ERROR: A save did not verify, profile index.
+ * - JOURNAL_AUTOSAVE:   Edits handed to the background save, profile index.
+ * - JOURNAL_TIME_SHIFT: Time shift set, hours.
+ * - JOURNAL_ALARM:      Alarm raised, `alarms_id_t`.
+ * - JOURNAL_ALARM_CLR:  Latched alarms acknowledged, mask of the alarms still active.
+ * - JOURNAL_I2C_ERROR:  An I2C device stopped answering, 7-bit address.
+ * - JOURNAL_BOOTLOADER: Rebooted to the bootloader from the menu.
+ */
+#define JOURNAL_EVENTS(X)             \
+	X(JOURNAL_BOOT, "BOOT")           \
+	X(JOURNAL_PROFILE, "PROFILE")     \
+	X(JOURNAL_SAVE, "SAVE")           \
+	X(JOURNAL_SAVE_ERROR, "SAVE ERR") \
+	X(JOURNAL_AUTOSAVE, "AUTOSAVE")   \
+	X(JOURNAL_TIME_SHIFT, "SHIFT")    \
+	X(JOURNAL_ALARM, "ALARM")         \
+	X(JOURNAL_ALARM_CLR, "ALM CLR")   \
+	X(JOURNAL_I2C_ERROR, "I2C ERR")   \
+	X(JOURNAL_BOOTLOADER, "BOOTLDR")
+
+/**
+ * @enum journal_event_id_t
+ * @brief Journal events, see `JOURNAL_EVENTS`.
+ */
+typedef enum
+{
+#define JOURNAL_ENUM(event, label) event,
+	JOURNAL_EVENTS(JOURNAL_ENUM)
+#undef JOURNAL_ENUM
+	JOURNAL_EVENT_COUNT
+} journal_event_id_t;
+
+/**
+ * @struct journal_event_t
+ * @brief One journal entry, 8 bytes. A slot whose `type` reads 0xFF is erased.
+ */
+typedef struct
+{
+	uint32_t seconds; // seconds since the boot
+	uint8_t	 type;	  // journal_event_id_t
+	uint8_t	 boot;	  // boot number, wraps at 256
+	int16_t	 arg;	  // event argument, see `JOURNAL_EVENTS`
+} journal_event_t;
+
+extern void		   journal_init();
+extern void		   journal_log(journal_event_id_t type, int arg);
+extern void		   journal_flush();
+extern int		   journal_count();
+extern bool		   journal_read(int age, journal_event_t* event);
+extern const char* journal_label(int type);
+extern void		   journal_print();
+
+#endif // JOURNAL_H
+
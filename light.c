@@ -0,0 +1,166 @@
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "task.h"
+#include "journal.h"
+#include "light.h"
+
+#define BH1750_POWER_ON		 0x01
+#define BH1750_CONTINUOUS_HR 0x10 // continuous high resolution mode, 1 lx per count / 1.2
+
+static bool		  available		 = false;		   // sensor answered at init
+static int32_t	  target_percent = 0;			   // scheduled LED level the light is regulated to
+static int32_t	  lux			 = 0;			   // last measured illuminance
+static int32_t	  trim_q8		 = LIGHT_TRIM_ONE; // current LED trim
+static bool		  read_failed	 = false;		   // last read failed, only the first failure in a row is journaled
+static light_pi_t pi;
+static task_t	  light_task;
+
+/**
+ * @brief Runs one step of the PI controller.
+ *
+ * The error is normalized to a Q8 fraction of `LIGHT_FULL_SCALE_LUX`. The trim can only lower the LED
+ * levels (daylight adds light, the controller never boosts above the schedule), and the integral is
+ * clamped to the same range to avoid wind-up. Pure function, no hardware access.
+ *
+ * @param pi           Controller state.
+ * @param target_lux   Illuminance the schedule asks for.
+ * @param measured_lux Illuminance measured at the sensor.
+ * @return The LED trim in Q8 (`LIGHT_TRIM_MIN_Q8` - `LIGHT_TRIM_ONE`).
+ */
+int32_t light_pi_update(light_pi_t* pi, int32_t target_lux, int32_t measured_lux)
+{
+	int32_t error_q8  = (target_lux - measured_lux) * 256 / LIGHT_FULL_SCALE_LUX;
+
+	pi->integral	 += error_q8 * LIGHT_KI_Q8 / 256;
+	if(pi->integral > 0)
+	{
+		pi->integral = 0;
+	} else if(pi->integral < LIGHT_TRIM_MIN_Q8 - LIGHT_TRIM_ONE)
+	{
+		pi->integral = LIGHT_TRIM_MIN_Q8 - LIGHT_TRIM_ONE;
+	}
+
+	int32_t trim = LIGHT_TRIM_ONE + error_q8 * LIGHT_KP_Q8 / 256 + pi->integral;
+	if(trim > LIGHT_TRIM_ONE)
+	{
+		trim = LIGHT_TRIM_ONE;
+	} else if(trim < LIGHT_TRIM_MIN_Q8)
+	{
+		trim = LIGHT_TRIM_MIN_Q8;
+	}
+	return trim;
+}
+
+/**
+ * @brief Sends a one byte command to the sensor.
+ *
+ * @return true if the sensor acknowledged it.
+ */
+static bool light_command(uint8_t command)
+{
+	return i2c_write_timeout_us(i2c1, LIGHT_I2C_ADDRESS, &command, 1, false, LIGHT_I2C_TIMEOUT_US) == 1;
+}
+
+/**
+ * @brief Reads the latest conversion of the sensor.
+ *
+ * @param result Receives the illuminance in lux.
+ * @return true on success.
+ */
+static bool light_read(int32_t* result)
+{
+	uint8_t data[2];
+	if(i2c_read_timeout_us(i2c1, LIGHT_I2C_ADDRESS, data, 2, false, LIGHT_I2C_TIMEOUT_US) != 2)
+	{
+		return false;
+	}
+	*result = ((data[0] << 8) | data[1]) * 5 / 6;
+	return true;
+}
+
+/**
+ * @brief Measures the light and updates the LED trim every `LIGHT_PERIOD_MS`.
+ *
+ * While the schedule has the LEDs off there is nothing to regulate, so the controller is reset and
+ * starts from the untrimmed level at the next light period.
+ */
+static task_status_t light_task_fn(task_t* task)
+{
+	TASK_BEGIN(task);
+	while(true)
+	{
+		TASK_SLEEP_MS(task, LIGHT_PERIOD_MS);
+
+		if(!light_read(&lux))
+		{
+			if(!read_failed)
+			{
+				journal_log(JOURNAL_I2C_ERROR, LIGHT_I2C_ADDRESS);
+			}
+			read_failed = true;
+			continue; // keep the last trim, try again next period
+		}
+		read_failed = false;
+		if(target_percent == 0)
+		{
+			pi		= (light_pi_t) {0};
+			trim_q8 = LIGHT_TRIM_ONE;
+			continue;
+		}
+		trim_q8 = light_pi_update(&pi, target_percent * LIGHT_FULL_SCALE_LUX / 100, lux);
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Looks for the light sensor and starts the control loop if it is present.
+ *
+ * Must run after the OLED I2C bus has been set up by `app_init()`. Without a sensor the trim stays
+ * at `LIGHT_TRIM_ONE`.
+ *
+ * The display and the sensor share i2c1 and are both driven from the main loop, so their transfers
+ * never overlap. The sensor runs in continuous mode: each control step is a single 2-byte read with a
+ * timeout and never waits for a conversion, so it cannot hold up a redraw.
+ */
+void light_init()
+{
+	available = light_command(BH1750_POWER_ON) && light_command(BH1750_CONTINUOUS_HR);
+	if(available)
+	{
+		task_start(&light_task, light_task_fn);
+	}
+}
+
+/**
+ * @brief Checks whether a light sensor was found.
+ */
+bool light_available()
+{
+	return available;
+}
+
+/**
+ * @brief Sets the scheduled LED level the delivered light is regulated to.
+ *
+ * @param percent The scheduled white/red level (0-100).
+ */
+void light_set_target_percent(int percent)
+{
+	target_percent = percent;
+}
+
+/**
+ * @brief Returns the LED trim in Q8 (`LIGHT_TRIM_ONE` = no trim).
+ */
+int32_t light_trim_q8()
+{
+	return trim_q8;
+}
+
+/**
+ * @brief Returns the last measured illuminance in lux.
+ */
+int32_t light_lux()
+{
+	return lux;
+}
@@ -0,0 +1,36 @@
+#ifndef LIGHT_H
+#define LIGHT_H
+
+#include "pico/stdlib.h"
+
+#define LIGHT_I2C_ADDRESS	 0x23  // BH1750 with ADDR tied low, shares i2c1 with the OLED
+#define LIGHT_PERIOD_MS		 1000  // control loop period
+#define LIGHT_I2C_TIMEOUT_US 2000  // upper bound of one sensor transfer
+#define LIGHT_FULL_SCALE_LUX 20000 // lux the LEDs deliver at the sensor at 100% with no daylight
+#define LIGHT_KP_Q8			 128   // proportional gain (0.5) on the error as a fraction of full scale
+#define LIGHT_KI_Q8			 64	   // integral gain (0.25 per period)
+#define LIGHT_TRIM_MIN_Q8	 64	   // lowest LED trim (25%), daylight never switches the LEDs off entirely
+
+#define LIGHT_TRIM_ONE 256 // LED trim without daylight compensation (Q8)
+
+/**
+ * @struct light_pi_t
+ * @brief State of the PI controller that trims the LED levels.
+ *
+ * @var light_pi_t::integral
+ *   Integral term in Q8, clamped so the trim stays within `LIGHT_TRIM_MIN_Q8` - `LIGHT_TRIM_ONE`.
+ */
+typedef struct
+{
+	int32_t integral;
+} light_pi_t;
+
+extern void	   light_init();
+extern bool	   light_available();
+extern void	   light_set_target_percent(int percent);
+extern int32_t light_trim_q8();
+extern int32_t light_lux();
+
+extern int32_t light_pi_update(light_pi_t* pi, int32_t target_lux, int32_t measured_lux);
+
+#endif // LIGHT_H
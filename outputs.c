@@ -0,0 +1,543 @@
+#include <assert.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "pins.h"
+#include "power.h"
+#include "outputs.h"
+#if OUTPUT_DITHER
+#include "hardware/structs/systick.h"
+#endif
+
+/**
+ * @brief True if the PWM frequency is exactly reachable at the given system clock with divider 1.
+ *
+ * The period must divide the system clock evenly and fit the 16-bit counter (wrap + 1 <= 65535,
+ * which also keeps `level * period` within 32 bits).
+ */
+#define OUTPUT_PWM_EXACT_AT_KHZ(khz) \
+	((khz) * 1000u % OUTPUT_PWM_FREQ_HZ == 0 && (khz) * 1000u / OUTPUT_PWM_FREQ_HZ <= 0xFFFF)
+
+static_assert(OUTPUT_PWM_EXACT_AT_KHZ(POWER_CLOCK_IDLE_KHZ), "PWM frequency is not exact at the idle clock");
+static_assert(OUTPUT_PWM_EXACT_AT_KHZ(POWER_CLOCK_ACTIVE_KHZ), "PWM frequency is not exact at the active clock");
+static_assert(OUTPUT_PUMP_MW < OUTPUT_POWER_BUDGET_MW, "the power budget must cover the pump");
+
+static const uint output_led_pins[OUTPUT_LED_COUNT] = {
+	[OUTPUT_LED_WHITE_RED] = PIN_LED_WHITE_RED,
+	[OUTPUT_LED_BLUE]	   = PIN_LED_BLUE,
+};
+
+static const uint32_t output_led_mw[OUTPUT_LED_COUNT] = {
+	[OUTPUT_LED_WHITE_RED] = OUTPUT_LED_WHITE_RED_MW,
+	[OUTPUT_LED_BLUE]	   = OUTPUT_LED_BLUE_MW,
+};
+
+static uint32_t requested_levels[OUTPUT_LED_COUNT]; // requested LED levels (0 - OUTPUT_LEVEL_MAX)
+static uint32_t output_levels[OUTPUT_LED_COUNT];	// LED levels after the power budget
+static uint32_t budget_scale = OUTPUT_LEVEL_MAX;	// scale applied by the power budget (OUTPUT_LEVEL_MAX = none)
+static bool		pump_on		 = false;				// pump state, the pump load is reserved first
+static uint32_t pwm_divider	 = 1;					// integer PWM clock divider
+static uint32_t pwm_period	 = 0;					// PWM counter steps per period (wrap + 1)
+static uint32_t max_update_us = 0;					// worst time spent writing new compare values
+static uint32_t led_slice_mask = 0;					// PWM slices that drive LED channels
+
+#if !OUTPUT_DITHER
+static uint32_t			 staged_cc[NUM_PWM_SLICES];		  // compare register words waiting for the next wrap
+static uint32_t			 staged_cc_mask[NUM_PWM_SLICES];  // CC bits owned by LED channels, per slice
+static volatile uint32_t staged_slices = 0;				  // slices with a staged word, written by the wrap IRQ
+#endif
+
+#if OUTPUT_DITHER
+#define DITHER_BUFFERS 3 // one streamed, one published for the next pass, one to build the next update in
+
+// CC words, one per PWM period, then a gap word
+static uint32_t			  dither_seq[DITHER_BUFFERS][OUTPUT_DITHER_STEPS + 1];
+static uint32_t* volatile dither_active;			// sequence the control channel loads next
+static uint32_t* volatile dither_streamed;			// sequence the data channel streams, updated by the pass IRQ
+static int				  dither_data_chan;			// writes the slice CC register once per PWM wrap
+static int				  dither_ctrl_chan;			// restarts the data channel on `dither_active`
+static volatile uint32_t  dither_passes		= 0;	// sequence passes since boot, counted by the pass IRQ
+static uint32_t			  dither_irq_cycles = 0;	// worst CPU cycles spent in the pass IRQ
+#endif
+
+/**
+ * @brief Scales the LED levels down so the estimated load stays within `OUTPUT_POWER_BUDGET_MW`.
+ *
+ * The running pump cannot be dimmed, so its load is reserved first and the LEDs share what is left.
+ * All LED channels are scaled by the same factor, which keeps the color mix. One pass over the channels,
+ * integer math only. Pure function, no hardware access.
+ *
+ * @param requested Requested LED levels (0 - OUTPUT_LEVEL_MAX).
+ * @param pump_on   true if the pump is running.
+ * @param levels    Receives the limited LED levels.
+ * @return The applied scale, OUTPUT_LEVEL_MAX if the load fits the budget.
+ */
+uint32_t outputs_limit_power(const uint32_t requested[OUTPUT_LED_COUNT], bool pump_on,
+							 uint32_t levels[OUTPUT_LED_COUNT])
+{
+	uint32_t available = OUTPUT_POWER_BUDGET_MW - (pump_on ? OUTPUT_PUMP_MW : 0);
+	uint32_t load_mw   = 0;
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		// Rounded up, so the scaled levels cannot end up a few mW over the budget
+		load_mw += (requested[i] * (uint64_t) output_led_mw[i] + 0xFFFF) >> 16;
+	}
+
+	uint32_t scale = OUTPUT_LEVEL_MAX;
+	if(load_mw > available)
+	{
+		scale = (uint32_t) (((uint64_t) available << 16) / load_mw);
+	}
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		levels[i] = (uint32_t) (((uint64_t) requested[i] * scale) >> 16);
+	}
+	return scale;
+}
+
+/**
+ * @brief Checks whether an LED channel is end-aligned.
+ *
+ * With `OUTPUT_STAGGER` every other channel runs with inverted output polarity, so its pulse sits at
+ * the end of the PWM period while the others start at counter zero. Two channels then only overlap
+ * when their duty cycles add up to more than 100%, which spreads the LED current across the period
+ * instead of stacking both inrush edges at counter zero.
+ *
+ * @param led The LED channel, an `output_led_t`.
+ * @return true if the channel's output polarity is inverted.
+ */
+bool outputs_end_aligned(int led)
+{
+	return OUTPUT_STAGGER && (led & 1);
+}
+
+/**
+ * @brief Converts a number of PWM steps to the compare value of an LED channel.
+ *
+ * An end-aligned channel is high while the counter is at or above its compare value, so it gets
+ * `period - on steps` for the same brightness. Pure function, no hardware access.
+ *
+ * @param led      The LED channel, an `output_led_t`.
+ * @param on_steps PWM steps per period the channel is on (0 - `period`).
+ * @param period   PWM steps per period (wrap + 1).
+ * @return The compare value.
+ */
+uint32_t outputs_compare_value(int led, uint32_t on_steps, uint32_t period)
+{
+	return outputs_end_aligned(led) ? period - on_steps : on_steps;
+}
+
+#if OUTPUT_DITHER
+/**
+ * @brief Records which sequence the data channel streams. DMA IRQ of the control channel, once per pass.
+ *
+ * The control channel has just restarted the data channel, so its read address lies in the sequence it
+ * loaded. The time spent here is measured in CPU cycles with SysTick for the diagnostics screen.
+ */
+static void outputs_on_dither_pass()
+{
+	uint32_t start = systick_hw->cvr;
+	if(!dma_channel_get_irq0_status(dither_ctrl_chan))
+	{
+		return; // another channel on the shared IRQ
+	}
+	dma_channel_acknowledge_irq0(dither_ctrl_chan);
+
+	uintptr_t addr = dma_hw->ch[dither_data_chan].read_addr;
+	for(int i = 0; i < DITHER_BUFFERS; i++)
+	{
+		if(addr >= (uintptr_t) dither_seq[i] && addr <= (uintptr_t) (dither_seq[i] + OUTPUT_DITHER_STEPS))
+		{
+			dither_streamed = dither_seq[i];
+		}
+	}
+	dither_passes++;
+
+	uint32_t cycles = (start - systick_hw->cvr) & M0PLUS_SYST_CVR_CURRENT_BITS; // SysTick counts down
+	if(cycles > dither_irq_cycles)
+	{
+		dither_irq_cycles = cycles;
+	}
+}
+
+/**
+ * @brief Builds the dither sequence for the requested LED levels and hands it to the DMA.
+ *
+ * The LED level scaled to the PWM period is a whole number of steps plus a 16-bit fraction. A first order
+ * sigma-delta modulator spreads the fraction over `OUTPUT_DITHER_STEPS` periods, alternating between
+ * the two adjacent compare values, so the average duty cycle keeps the full 16-bit level even when
+ * the period only has a few hundred steps.
+ *
+ * The sequence is written to a buffer that is neither streamed nor published and then published with a
+ * single pointer write; the control DMA channel picks it up at the start of the next pass. With three
+ * buffers one is always free, so an update never waits for the DMA: a second update within one pass
+ * replaces the published sequence before the DMA has loaded it. The pass IRQ tracks which buffer is
+ * streamed, see `outputs_on_dither_pass()`. Callers run with interrupts enabled, so it has always caught
+ * up with the previous update by the time the next one picks its buffer.
+ *
+ * All LED channels must share one PWM slice (GPIO 28/29 are slice 6 A/B), since every sequence entry
+ * is a complete CC register word.
+ */
+static void outputs_update_compare()
+{
+	uint32_t* streamed = dither_streamed; // the IRQ may only move it on to `dither_active`
+	uint32_t* seq	   = dither_seq[0];
+	for(int i = 0; i < DITHER_BUFFERS; i++)
+	{
+		if(dither_seq[i] != streamed && dither_seq[i] != dither_active)
+		{
+			seq = dither_seq[i];
+			break;
+		}
+	}
+	uint32_t  acc[OUTPUT_LED_COUNT];
+	uint32_t  base[OUTPUT_LED_COUNT];
+	uint32_t  frac[OUTPUT_LED_COUNT];
+	uint	  shift[OUTPUT_LED_COUNT];
+
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		uint32_t on_q16 = output_levels[i] * pwm_period; // fits, period <= 0xFFFF
+		base[i]			= on_q16 >> 16;
+		frac[i]			= on_q16 & 0xFFFF;
+		acc[i]			= 0x8000; // start half way to spread the extra steps evenly
+		shift[i]		= pwm_gpio_to_channel(output_led_pins[i]) == PWM_CHAN_B ? 16 : 0;
+	}
+	for(int n = 0; n < OUTPUT_DITHER_STEPS; n++)
+	{
+		uint32_t word = 0;
+		for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+		{
+			acc[i]	 += frac[i];
+			word	 |= outputs_compare_value(i, base[i] + (acc[i] >> 16), pwm_period) << shift[i];
+			acc[i]	 &= 0xFFFF;
+		}
+		seq[n] = word;
+	}
+
+	__compiler_memory_barrier();
+	dither_active = seq;
+}
+
+/**
+ * @brief Starts the DMA channels that stream the dither sequence into the LED slice.
+ *
+ * The data channel writes one CC word per PWM wrap (DREQ of the slice) and chains to the control channel,
+ * which reloads the data channel's read address from `dither_active` and retriggers it. The sequence
+ * therefore loops forever, and a new one takes over at a pass boundary. The CPU only takes one short IRQ
+ * per pass, when the control channel completes, see `outputs_on_dither_pass()`. SysTick is started
+ * to time it.
+ */
+static void outputs_start_dither()
+{
+	uint slice_num	 = pwm_gpio_to_slice_num(output_led_pins[0]);
+
+	dither_data_chan = dma_claim_unused_channel(true);
+	dither_ctrl_chan = dma_claim_unused_channel(true);
+
+	dma_channel_config data = dma_channel_get_default_config(dither_data_chan);
+	channel_config_set_transfer_data_size(&data, DMA_SIZE_32);
+	channel_config_set_read_increment(&data, true);
+	channel_config_set_write_increment(&data, false);
+	channel_config_set_dreq(&data, pwm_get_dreq(slice_num));
+	channel_config_set_chain_to(&data, dither_ctrl_chan);
+	dma_channel_configure(dither_data_chan, &data, &pwm_hw->slice[slice_num].cc, NULL, OUTPUT_DITHER_STEPS, false);
+
+	dma_channel_config ctrl = dma_channel_get_default_config(dither_ctrl_chan);
+	channel_config_set_transfer_data_size(&ctrl, DMA_SIZE_32);
+	channel_config_set_read_increment(&ctrl, false);
+	channel_config_set_write_increment(&ctrl, false);
+	dma_channel_configure(dither_ctrl_chan, &ctrl, &dma_hw->ch[dither_data_chan].al3_read_addr_trig, &dither_active, 1,
+						  false);
+
+	systick_hw->rvr = M0PLUS_SYST_RVR_BITS;
+	systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS; // free running, CPU clock
+	dma_channel_set_irq0_enabled(dither_ctrl_chan, true);
+	irq_add_shared_handler(DMA_IRQ_0, outputs_on_dither_pass, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+	irq_set_enabled(DMA_IRQ_0, true);
+	dma_channel_start(dither_ctrl_chan);
+}
+#else
+/**
+ * @brief Writes the staged compare words of every slice. PWM wrap IRQ, one-shot.
+ *
+ * The LED slices are started together and wrap together, so writing right after the wrap of the
+ * first one leaves a whole period before the next wrap latches the new values on all of them.
+ */
+static void outputs_on_pwm_wrap()
+{
+	uint32_t slices = staged_slices & pwm_get_irq_status_mask();
+	if(!slices)
+	{
+		return;
+	}
+	for(uint slice_num = 0; slice_num < NUM_PWM_SLICES; slice_num++)
+	{
+		if(staged_slices & (1u << slice_num))
+		{
+			pwm_hw->slice[slice_num].cc = staged_cc[slice_num];
+			pwm_set_irq_enabled(slice_num, false);
+			pwm_clear_irq(slice_num);
+		}
+	}
+	staged_slices = 0;
+}
+
+/**
+ * @brief Stages the PWM compare values for the requested LED levels and commits them together.
+ *
+ * The compare value is scaled from the current PWM period, so the duty cycle does not change
+ * when the period is re-derived after a clock change.
+ *
+ * Both channels of a slice are written with one 32-bit CC register write. The CC register is double
+ * buffered and latched at the period wrap, so the two channels of a slice always switch to their new
+ * values in the same period, without a partial period. When the LEDs span several slices, the words
+ * are staged and written together from a one-shot wrap IRQ, so no slice gets its new value a period
+ * before the others.
+ */
+static void outputs_update_compare()
+{
+	uint32_t words[NUM_PWM_SLICES] = {0};
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		uint slice_num	   = pwm_gpio_to_slice_num(output_led_pins[i]);
+		uint shift		   = pwm_gpio_to_channel(output_led_pins[i]) == PWM_CHAN_B ? 16 : 0;
+		words[slice_num]  |= outputs_compare_value(i, (output_levels[i] * pwm_period) >> 16, pwm_period) << shift;
+	}
+
+	uint32_t ints = save_and_disable_interrupts();
+	for(uint slice_num = 0; slice_num < NUM_PWM_SLICES; slice_num++)
+	{
+		if(led_slice_mask & (1u << slice_num))
+		{
+			staged_cc[slice_num] = (pwm_hw->slice[slice_num].cc & ~staged_cc_mask[slice_num]) | words[slice_num];
+		}
+	}
+	if((led_slice_mask & (led_slice_mask - 1)) == 0)
+	{
+		// Single slice: the double-buffered CC register already commits both channels at the wrap
+		uint slice_num				= pwm_gpio_to_slice_num(output_led_pins[0]);
+		pwm_hw->slice[slice_num].cc = staged_cc[slice_num];
+	} else
+	{
+		uint slice_num = pwm_gpio_to_slice_num(output_led_pins[0]);
+		staged_slices  = led_slice_mask;
+		pwm_clear_irq(slice_num);
+		pwm_set_irq_enabled(slice_num, true);
+	}
+	restore_interrupts(ints);
+}
+#endif
+
+/**
+ * @brief Sets the output polarity of every LED slice from `outputs_end_aligned()`.
+ */
+static void outputs_configure_polarity()
+{
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		uint slice_num = pwm_gpio_to_slice_num(output_led_pins[i]);
+		bool invert[2] = {false, false};
+		for(int j = 0; j < OUTPUT_LED_COUNT; j++)
+		{
+			if(pwm_gpio_to_slice_num(output_led_pins[j]) == slice_num)
+			{
+				invert[pwm_gpio_to_channel(output_led_pins[j])] = outputs_end_aligned(j);
+			}
+		}
+		pwm_set_output_polarity(slice_num, invert[PWM_CHAN_A], invert[PWM_CHAN_B]);
+	}
+}
+
+/**
+ * @brief Derives the PWM divider and wrap from the system clock.
+ *
+ * Picks the smallest integer divider that keeps the period within the 16-bit counter, then
+ * programs every LED slice and rescales the compare values.
+ *
+ * @param sys_hz The system clock frequency in Hz.
+ */
+static void outputs_configure_pwm(uint32_t sys_hz)
+{
+	uint32_t cycles = sys_hz / OUTPUT_PWM_FREQ_HZ;
+
+	pwm_divider		= (cycles + 0xFFFE) / 0xFFFF;
+	if(pwm_divider > 255)
+	{
+		pwm_divider = 255;
+	}
+	pwm_period = cycles / pwm_divider;
+
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		uint slice_num = pwm_gpio_to_slice_num(output_led_pins[i]);
+		pwm_set_clkdiv_int_frac(slice_num, pwm_divider, 0);
+		pwm_set_wrap(slice_num, pwm_period - 1);
+	}
+	outputs_update_compare();
+}
+
+/**
+ * @brief Initializes the LED PWM outputs and the pump pin.
+ *
+ * All outputs start switched off. The PWM timing is re-derived on every system clock change.
+ * With `OUTPUT_STAGGER` every other LED channel is end-aligned, see `outputs_end_aligned()`.
+ * With `OUTPUT_DITHER` the compare values are streamed by DMA, see `outputs_update_compare()`.
+ * The LED slices are started together so multi-slice updates can be committed at a common wrap.
+ */
+void outputs_init()
+{
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		uint slice_num		 = pwm_gpio_to_slice_num(output_led_pins[i]);
+		requested_levels[i]	 = 0;
+		output_levels[i]	 = 0;
+		led_slice_mask		|= 1u << slice_num;
+#if !OUTPUT_DITHER
+		staged_cc_mask[slice_num] |= pwm_gpio_to_channel(output_led_pins[i]) == PWM_CHAN_B ? 0xFFFF0000u : 0xFFFFu;
+#endif
+		gpio_set_function(output_led_pins[i], GPIO_FUNC_PWM);
+	}
+#if !OUTPUT_DITHER
+	if(led_slice_mask & (led_slice_mask - 1))
+	{
+		irq_add_shared_handler(PWM_IRQ_WRAP, outputs_on_pwm_wrap, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(PWM_IRQ_WRAP, true);
+	}
+#endif
+
+	outputs_configure_polarity();
+#if OUTPUT_DITHER
+	dither_active	= dither_seq[0];
+	dither_streamed = dither_seq[0];
+#endif
+	outputs_configure_pwm(clock_get_hz(clk_sys));
+#if OUTPUT_DITHER
+	outputs_start_dither();
+#endif
+
+	// Start all LED slices in the same cycle so their periods stay aligned
+	pwm_set_mask_enabled(pwm_hw->en | led_slice_mask);
+
+	// Init pin for water pump
+	gpio_init(PIN_PUMP);
+	gpio_set_dir(PIN_PUMP, GPIO_OUT);
+
+	power_add_clock_listener(outputs_configure_pwm);
+}
+
+/**
+ * @brief Applies the power budget to the requested levels and updates the PWM outputs.
+ */
+static void outputs_update_levels()
+{
+	absolute_time_t start = get_absolute_time();
+
+	budget_scale		  = outputs_limit_power(requested_levels, pump_on, output_levels);
+	outputs_update_compare();
+
+	uint32_t update_us	  = (uint32_t) absolute_time_diff_us(start, get_absolute_time());
+	if(update_us > max_update_us)
+	{
+		max_update_us = update_us;
+	}
+}
+
+/**
+ * @brief Sets the LED levels.
+ *
+ * The levels are scaled down if the LEDs and the pump together would exceed `OUTPUT_POWER_BUDGET_MW`.
+ *
+ * @param levels Level per LED channel, 0 (off) to OUTPUT_LEVEL_MAX (fully on).
+ */
+void outputs_set_led_levels(const uint32_t levels[OUTPUT_LED_COUNT])
+{
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		requested_levels[i] = levels[i] > OUTPUT_LEVEL_MAX ? OUTPUT_LEVEL_MAX : levels[i];
+	}
+	outputs_update_levels();
+}
+
+/**
+ * @brief Switches the water pump on or off.
+ *
+ * The LED levels are re-budgeted when the pump state changes.
+ */
+void outputs_set_pump(bool on)
+{
+	gpio_put(PIN_PUMP, on);
+	if(on != pump_on)
+	{
+		pump_on = on;
+		outputs_update_levels();
+	}
+}
+
+/**
+ * @brief Checks whether the water pump is switched on.
+ */
+bool outputs_pump_is_on()
+{
+	return pump_on;
+}
+
+/**
+ * @brief Returns the LED PWM frequency produced by the current configuration.
+ *
+ * @return The PWM frequency in Hz.
+ */
+uint32_t outputs_pwm_frequency()
+{
+	return clock_get_hz(clk_sys) / (pwm_divider * pwm_period);
+}
+
+/**
+ * @brief Returns the scale the power budget currently applies to the LED levels.
+ *
+ * @return The scale, OUTPUT_LEVEL_MAX if the requested levels fit the budget.
+ */
+uint32_t outputs_budget_scale()
+{
+	return budget_scale;
+}
+
+/**
+ * @brief Returns the worst time spent applying new LED levels (budget, compare values, dither sequence).
+ *
+ * @return The time in microseconds.
+ */
+uint32_t outputs_max_update_us()
+{
+	return max_update_us;
+}
+
+/**
+ * @brief Returns the worst CPU cycles spent in the dither pass IRQ, 0 without `OUTPUT_DITHER`.
+ *
+ * The DMA itself adds one bus write per PWM period and one per pass, which the CPU does not see.
+ */
+uint32_t outputs_dither_irq_cycles()
+{
+#if OUTPUT_DITHER
+	return dither_irq_cycles;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief Returns the dither sequence passes since boot, 0 without `OUTPUT_DITHER`.
+ */
+uint32_t outputs_dither_passes()
+{
+#if OUTPUT_DITHER
+	return dither_passes;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef OUTPUTS_H
+#define OUTPUTS_H
+
+#include "pico/stdlib.h"
+
+#define OUTPUT_DITHER		0		  // 1 to dither the LED compare values at a flicker-free PWM frequency
+#define OUTPUT_DITHER_STEPS 128		  // PWM periods per dither sequence (adds 7 bits of resolution)
+#define OUTPUT_LEVEL_MAX	(1u << 16) // full scale LED level (100%)
+#define OUTPUT_STAGGER		1		  // 1 to end-align every other LED channel so the pulses overlap as little as possible
+
+#if OUTPUT_DITHER
+#define OUTPUT_PWM_FREQ_HZ 40000 // LED PWM frequency, kept exact at every supported clock point
+#else
+#define OUTPUT_PWM_FREQ_HZ 5000 // LED PWM frequency, kept exact at every supported clock point
+#endif
+
+#define OUTPUT_POWER_BUDGET_MW	  36000 // what the 24 V supply and the regulator can deliver to the outputs
+#define OUTPUT_LED_WHITE_RED_MW	  30000 // white/red LED load at 100%
+#define OUTPUT_LED_BLUE_MW		  10000 // blue LED load at 100%
+#define OUTPUT_PUMP_MW			  6000	// pump load while running
+
+/**
+ * @brief Converts a power percentage (0-100) to an output level.
+ */
+#define OUTPUT_LEVEL_FROM_PERCENT(p) ((uint32_t) (p) * OUTPUT_LEVEL_MAX / 100)
+
+/**
+ * @enum output_led_t
+ * @brief LED channels driven by PWM.
+ */
+typedef enum
+{
+	OUTPUT_LED_WHITE_RED,
+	OUTPUT_LED_BLUE,
+	OUTPUT_LED_COUNT
+} output_led_t;
+
+extern void		outputs_init();
+extern void		outputs_set_led_levels(const uint32_t levels[OUTPUT_LED_COUNT]);
+extern void		outputs_set_pump(bool on);
+extern bool		outputs_pump_is_on();
+extern uint32_t outputs_pwm_frequency();
+extern uint32_t outputs_budget_scale();
+extern uint32_t outputs_max_update_us();
+extern uint32_t outputs_dither_irq_cycles();
+extern uint32_t outputs_dither_passes();
+
+extern uint32_t outputs_limit_power(const uint32_t requested[OUTPUT_LED_COUNT], bool pump_on,
+									uint32_t levels[OUTPUT_LED_COUNT]);
+extern bool		outputs_end_aligned(int led);
+extern uint32_t outputs_compare_value(int led, uint32_t on_steps, uint32_t period);
+
+#endif // OUTPUTS_H
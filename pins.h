@@ -13,4 +13,13 @@
 
 #define PIN_BUTTON          6
 
+#define PIN_FLOW_METER      7 // hall-effect flow sensor pulse output
+
+#define PIN_SENSE_ADC       26 // ADC0, pump current sense
+
+// Optional pump sensors. Without the hardware their inputs read as no flow and no current, which the
+// detectors would take for a fault on every pump run, so they stay off until the board is fitted.
+#define PUMP_FLOW_SENSOR    0 // 1 if a flow sensor is fitted on PIN_FLOW_METER, enables ALARM_PUMP_NO_FLOW
+#define PUMP_CURRENT_SENSE  0 // 1 if a shunt amplifier is fitted on PIN_SENSE_ADC, enables the current alarms
+
 #endif // _GARDEN_PINS_H__
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "power.h"
+
+static const uint32_t power_clock_table_khz[POWER_CLOCK_COUNT] = {
+	[POWER_CLOCK_IDLE]	 = POWER_CLOCK_IDLE_KHZ,
+	[POWER_CLOCK_ACTIVE] = POWER_CLOCK_ACTIVE_KHZ,
+};
+
+static power_clock_t		  current_clock = POWER_CLOCK_ACTIVE; // clock point currently in use
+static absolute_time_t		  last_boost_time;					  // last time the active clock was requested
+static power_clock_listener_t clock_listeners[POWER_MAX_LISTENERS];
+static int					  clock_listener_count = 0;
+static volatile bool		  wake_pending		   = false; // set from IRQ context by power_wake()
+
+/**
+ * @brief Returns the system clock frequency of an operating point.
+ *
+ * @param clock The operating point.
+ * @return The system clock frequency in kHz.
+ */
+uint32_t power_clock_khz(power_clock_t clock)
+{
+	return power_clock_table_khz[clock];
+}
+
+/**
+ * @brief Switches the system clock to the given operating point.
+ *
+ * The PLL is reprogrammed through `set_sys_clock_khz()`, after which every registered listener
+ * is notified with the new frequency so it can re-derive its dividers (PWM, I2C, ...).
+ * The stdio UART is re-timed here as well because clk_peri may follow clk_sys.
+ *
+ * @param clock The operating point to switch to.
+ */
+static void power_set_clock(power_clock_t clock)
+{
+	if(clock == current_clock)
+	{
+		return;
+	}
+
+	set_sys_clock_khz(power_clock_khz(clock), true);
+	current_clock	= clock;
+
+	uint32_t sys_hz = clock_get_hz(clk_sys);
+#if LIB_PICO_STDIO_UART
+	uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+	for(int i = 0; i < clock_listener_count; i++)
+	{
+		clock_listeners[i](sys_hz);
+	}
+}
+
+/**
+ * @brief Initializes the power manager.
+ *
+ * Starts at the active clock point so the boot sequence (display init, flash reads) runs at full speed.
+ * The clock drops to the idle point once `power_tick()` sees no boost for `POWER_ACTIVE_HOLD_MS`.
+ */
+void power_init()
+{
+	current_clock = POWER_CLOCK_COUNT; // force the first switch
+	power_set_clock(POWER_CLOCK_ACTIVE);
+	last_boost_time = get_absolute_time();
+}
+
+/**
+ * @brief Registers a function to be called after every system clock change.
+ *
+ * @param listener The callback to register. Ignored if the listener table is full.
+ */
+void power_add_clock_listener(power_clock_listener_t listener)
+{
+	if(clock_listener_count < POWER_MAX_LISTENERS)
+	{
+		clock_listeners[clock_listener_count++] = listener;
+	}
+}
+
+/**
+ * @brief Requests the active clock point.
+ *
+ * Called on UI interaction and before redraws. The clock stays active for `POWER_ACTIVE_HOLD_MS`
+ * after the last call.
+ */
+void power_boost()
+{
+	last_boost_time = get_absolute_time();
+	power_set_clock(POWER_CLOCK_ACTIVE);
+}
+
+/**
+ * @brief Periodic power manager handler.
+ *
+ * Drops to the idle clock point once no boost has been requested for `POWER_ACTIVE_HOLD_MS`.
+ */
+void power_tick()
+{
+	if(current_clock != POWER_CLOCK_IDLE &&
+	   absolute_time_diff_us(last_boost_time, get_absolute_time()) > POWER_ACTIVE_HOLD_MS * 1000)
+	{
+		power_set_clock(POWER_CLOCK_IDLE);
+	}
+}
+
+/**
+ * @brief Waits for events until the given time or until `power_wake()` is called.
+ *
+ * The core waits for events with the timer alarm at `wake_time` as the upper bound, without changing
+ * the system clock. Only the core is halted: the PWM slices, the PIO encoder and the GPIO outputs
+ * keep running, so LED and pump outputs are not affected.
+ *
+ * A wake request made while the core was awake makes this function return immediately, so an input
+ * event that arrives between the caller's checks and the wait is never lost.
+ *
+ * @param wake_time The latest time to wake up.
+ */
+void power_wait_until(absolute_time_t wake_time)
+{
+	while(!wake_pending)
+	{
+		if(best_effort_wfe_or_timeout(wake_time))
+		{
+			break; // timer alarm reached
+		}
+	}
+	wake_pending = false;
+}
+
+/**
+ * @brief Sleeps the core at the idle clock until the given time or until `power_wake()` is called.
+ *
+ * @param wake_time The latest time to wake up.
+ */
+void power_sleep_until(absolute_time_t wake_time)
+{
+	power_set_clock(POWER_CLOCK_IDLE);
+	power_wait_until(wake_time);
+}
+
+/**
+ * @brief Ends a `power_wait_until()` or `power_sleep_until()` early.
+ *
+ * Safe to call from IRQ context, typically when the input module queues an event.
+ */
+void power_wake()
+{
+	wake_pending = true;
+	__sev();
+}
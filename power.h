@@ -0,0 +1,41 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include "pico/stdlib.h"
+
+#define POWER_CLOCK_IDLE_KHZ   18000  // system clock while the UI is idle
+#define POWER_CLOCK_ACTIVE_KHZ 125000 // system clock during UI interaction and redraws
+#define POWER_ACTIVE_HOLD_MS   2000	  // stay at the active clock this long after the last boost
+#define POWER_MAX_LISTENERS	   4	  // maximum number of clock change listeners
+
+/**
+ * @enum power_clock_t
+ * @brief Supported system clock operating points.
+ *
+ * - POWER_CLOCK_IDLE:   Low system clock, used while nothing but the schedule is running.
+ * - POWER_CLOCK_ACTIVE: Full system clock, used for UI interaction and redraw bursts.
+ */
+typedef enum
+{
+	POWER_CLOCK_IDLE,
+	POWER_CLOCK_ACTIVE,
+	POWER_CLOCK_COUNT
+} power_clock_t;
+
+/**
+ * @brief Callback invoked after the system clock has been changed.
+ *
+ * @param sys_hz The new system clock frequency in Hz.
+ */
+typedef void (*power_clock_listener_t)(uint32_t sys_hz);
+
+extern void		power_init();
+extern void		power_add_clock_listener(power_clock_listener_t listener);
+extern void		power_boost();
+extern void		power_tick();
+extern uint32_t power_clock_khz(power_clock_t clock);
+extern void		power_wait_until(absolute_time_t wake_time);
+extern void		power_sleep_until(absolute_time_t wake_time);
+extern void		power_wake();
+
+#endif // POWER_H
@@ -0,0 +1,175 @@
+#include <assert.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "profile.h"
+
+#define RECORD_NAME		0  // offsets of the record fields, see PROFILE_RECORD_SIZE
+#define RECORD_TYPE		12
+#define RECORD_LATITUDE	13
+#define RECORD_VERSION	14
+#define RECORD_PERIODS	15
+#define RECORD_PERIOD	16
+
+#define RECORD_MAX_PERIODS ((PROFILE_RECORD_SIZE - RECORD_PERIOD) / 4) // periods a record slot can hold
+
+static_assert(PERIOD_BLUE_SHIFT + PERIOD_LEVEL_BITS <= 32, "packed period does not fit a word");
+static_assert(MAX_PERIODS <= RECORD_MAX_PERIODS, "the periods do not fit a record slot");
+static_assert(RECORD_TYPE == PROFILE_NAME_LEN, "the name field must end where the type starts");
+
+/**
+ * @brief Clamps a value to 0 - max.
+ */
+static uint32_t profile_clamp(int value, uint32_t max)
+{
+	if(value < 0)
+	{
+		return 0;
+	}
+	return (uint32_t) value > max ? max : (uint32_t) value;
+}
+
+/**
+ * @brief Packs a period into one word. Out of range values are clamped.
+ *
+ * @param period The period to pack.
+ * @return The packed period.
+ */
+period_packed_t profile_encode_period(const period_t* period)
+{
+	return PERIOD_PACK(profile_clamp(period->duration, PERIOD_DURATION_MAX),
+					   profile_clamp(period->led_white_red_power, PERIOD_LEVEL_MAX),
+					   profile_clamp(period->led_blue_power, PERIOD_LEVEL_MAX));
+}
+
+/**
+ * @brief Unpacks a period.
+ *
+ * @param packed The packed period.
+ * @param period Receives the unpacked fields.
+ */
+void profile_decode_period(period_packed_t packed, period_t* period)
+{
+	period->duration			= PERIOD_DURATION(packed);
+	period->led_white_red_power = PERIOD_WHITE_RED(packed);
+	period->led_blue_power		= PERIOD_BLUE(packed);
+}
+
+/**
+ * @brief Unpacks one period of a profile for editing or drawing.
+ *
+ * @param profile The profile.
+ * @param index   Period index, 0 - MAX_PERIODS-1.
+ * @param period  Receives the unpacked fields.
+ */
+void profile_get_period(const profile_t* profile, int index, period_t* period)
+{
+	profile_decode_period(profile->periods[index], period);
+}
+
+/**
+ * @brief Packs an edited period back into a profile.
+ *
+ * @param profile The profile.
+ * @param index   Period index, 0 - MAX_PERIODS-1.
+ * @param period  The new period values, clamped to the packed field ranges.
+ */
+void profile_set_period(profile_t* profile, int index, const period_t* period)
+{
+	profile->periods[index] = profile_encode_period(period);
+}
+
+/**
+ * @brief Returns the length of one profile cycle, the sum of all period durations in minutes.
+ */
+uint32_t profile_total_minutes(const profile_t* profile)
+{
+	uint32_t total = 0;
+	for(int i = 0; i < MAX_PERIODS; i++)
+	{
+		total += PERIOD_DURATION(profile->periods[i]);
+	}
+	return total;
+}
+
+/**
+ * @brief Brings a profile read from storage back into range.
+ *
+ * Terminates the name, resets an unknown type to PROFILE_FIXED and clamps every period level to 100%.
+ *
+ * @param profile The profile to fix up in place.
+ */
+void profile_sanitize(profile_t* profile)
+{
+	profile->name[PROFILE_NAME_LEN - 1] = '\0';
+	if(profile->type > PROFILE_SUN)
+	{
+		profile->type = PROFILE_FIXED;
+	}
+	for(int i = 0; i < MAX_PERIODS; i++)
+	{
+		period_t period;
+		profile_decode_period(profile->periods[i], &period);
+		profile->periods[i] = profile_encode_period(&period);
+	}
+}
+
+/**
+ * @brief Encodes a profile into its flash record, see `PROFILE_RECORD_SIZE` for the layout.
+ *
+ * Unused period slots and the rest of the record are zero, so equal profiles always give equal records.
+ *
+ * @param profile The profile.
+ * @param record  Receives `PROFILE_RECORD_SIZE` bytes.
+ */
+void profile_encode(const profile_t* profile, uint8_t* record)
+{
+	memset(record, 0, PROFILE_RECORD_SIZE);
+	memcpy(record + RECORD_NAME, profile->name, PROFILE_NAME_LEN);
+	record[RECORD_NAME + PROFILE_NAME_LEN - 1] = '\0';
+	record[RECORD_TYPE]						   = profile->type;
+	record[RECORD_LATITUDE]					   = (uint8_t) profile->latitude;
+	record[RECORD_VERSION]					   = PROFILE_RECORD_VERSION;
+	record[RECORD_PERIODS]					   = MAX_PERIODS;
+	for(int i = 0; i < MAX_PERIODS; i++)
+	{
+		uint8_t*		field = record + RECORD_PERIOD + i * 4;
+		period_packed_t value = profile->periods[i];
+		field[0]			  = value;
+		field[1]			  = value >> 8;
+		field[2]			  = value >> 16;
+		field[3]			  = value >> 24;
+	}
+}
+
+/**
+ * @brief Decodes a flash record into a profile.
+ *
+ * Periods missing from the record are left at zero (disabled) and periods beyond `MAX_PERIODS` are
+ * dropped. The profile is sanitized.
+ *
+ * @param record  `PROFILE_RECORD_SIZE` bytes as read from flash.
+ * @param profile Receives the profile.
+ * @return false if the record version is unknown or the record is inconsistent, `profile` is then zeroed.
+ */
+bool profile_decode(const uint8_t* record, profile_t* profile)
+{
+	memset(profile, 0, sizeof(*profile));
+
+	int version = record[RECORD_VERSION];
+	int periods = record[RECORD_PERIODS];
+	if(version != PROFILE_RECORD_VERSION || periods > RECORD_MAX_PERIODS)
+	{
+		return false;
+	}
+
+	memcpy(profile->name, record + RECORD_NAME, PROFILE_NAME_LEN);
+	profile->type	  = record[RECORD_TYPE];
+	profile->latitude = (int8_t) record[RECORD_LATITUDE];
+	for(int i = 0; i < periods && i < MAX_PERIODS; i++)
+	{
+		const uint8_t* field = record + RECORD_PERIOD + i * 4;
+		profile->periods[i]	 = field[0] | (field[1] << 8) | (field[2] << 16) | ((period_packed_t) field[3] << 24);
+	}
+	profile_sanitize(profile);
+	return true;
+}
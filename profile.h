@@ -0,0 +1,117 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "pico/stdlib.h"
+
+#define MAX_PERIODS		 6	// up to 6 periods per profile
+#define PROFILE_NAME_LEN 12 // profile name including the terminator, 11 characters fit the screen at scale 2
+
+#define PERIOD_DURATION_BITS	11 // minutes, 0 - 2047
+#define PERIOD_LEVEL_BITS		7  // percent, 0 - 127
+#define PERIOD_WHITE_RED_SHIFT	PERIOD_DURATION_BITS
+#define PERIOD_BLUE_SHIFT		(PERIOD_DURATION_BITS + PERIOD_LEVEL_BITS)
+#define PERIOD_DURATION_MAX		((1u << PERIOD_DURATION_BITS) - 1)
+#define PERIOD_LEVEL_MASK		((1u << PERIOD_LEVEL_BITS) - 1)
+#define PERIOD_LEVEL_MAX		100
+
+/**
+ * @brief Flash record of a profile, written by `profile_encode()` byte by byte so it does not depend on
+ * the compiler's struct layout. Multi-byte fields are little-endian.
+ *
+ * | Offset | Size | Field                                                         |
+ * |--------|------|---------------------------------------------------------------|
+ * | 0      | 12   | name, zero terminated                                         |
+ * | 12     | 1    | type, `profile_type_t`                                        |
+ * | 13     | 1    | latitude, signed degrees                                      |
+ * | 14     | 1    | record version, `PROFILE_RECORD_VERSION`                      |
+ * | 15     | 1    | number of periods that follow                                 |
+ * | 16     | 4*n  | periods, one `period_packed_t` each                           |
+ */
+#define PROFILE_RECORD_SIZE	   40 // bytes of a record slot
+#define PROFILE_RECORD_VERSION 1  // record version written by profile_encode()
+
+/**
+ * @brief A period packed into one 32-bit word: duration in bits 0-10, white/red level in bits 11-17,
+ * blue level in bits 18-24. Bits 25-31 are reserved and zero.
+ */
+typedef uint32_t period_packed_t;
+
+/**
+ * @brief Packs a period from constants, for static initializers. The values are not range checked.
+ */
+#define PERIOD_PACK(duration, white_red, blue)                                                  \
+	((period_packed_t) (duration) | ((period_packed_t) (white_red) << PERIOD_WHITE_RED_SHIFT) | \
+	 ((period_packed_t) (blue) << PERIOD_BLUE_SHIFT))
+
+/**
+ * @brief Field accessors of a packed period, durations in minutes and levels in percent.
+ */
+#define PERIOD_DURATION(p)	((int) ((p) & PERIOD_DURATION_MAX))
+#define PERIOD_WHITE_RED(p)	((int) (((p) >> PERIOD_WHITE_RED_SHIFT) & PERIOD_LEVEL_MASK))
+#define PERIOD_BLUE(p)		((int) (((p) >> PERIOD_BLUE_SHIFT) & PERIOD_LEVEL_MASK))
+
+/**
+ * @struct period_t
+ * @brief Unpacked period, used while a period is edited or drawn.
+ *
+ * @var period_t::duration
+ *   Duration of the period in minutes. Set to 0 to disable this period.
+ * @var period_t::led_white_red_power
+ *   Power level for white and red LEDs (range: 0-100).
+ * @var period_t::led_blue_power
+ *   Power level for blue LED (range: 0-100).
+ */
+typedef struct
+{
+	int duration;			 // minutes. 0 to disable period
+	int led_white_red_power; // white and red leds power 0-100
+	int led_blue_power;		 // blue led power 0-100
+} period_t;
+
+/**
+ * @enum profile_type_t
+ * @brief How the periods of a profile are timed.
+ *
+ * - PROFILE_FIXED: The period durations are set by the user.
+ * - PROFILE_SUN:   Period 1 lasts from sunrise to sunset and period 2 the rest of the day, for the
+ *                  profile latitude and the current day of year. Recomputed once per day.
+ */
+typedef enum
+{
+	PROFILE_FIXED,
+	PROFILE_SUN
+} profile_type_t;
+
+/**
+ * @struct profile_t
+ * @brief A profile in its compact form, as the scheduler reads it. Stored with `profile_encode()`, never as
+ * a raw copy.
+ *
+ * @var profile_t::name
+ *   The profile name (null-terminated string).
+ * @var profile_t::type
+ *   How the period durations are set, see `profile_type_t`.
+ * @var profile_t::latitude
+ *   Latitude in degrees (north positive), used by PROFILE_SUN.
+ * @var profile_t::periods
+ *   Packed periods, see `period_packed_t`. Use `profile_get_period()` / `profile_set_period()` to edit.
+ */
+typedef struct
+{
+	char			name[PROFILE_NAME_LEN]; // profile name
+	uint8_t			type;					// profile_type_t
+	int8_t			latitude;				// degrees, PROFILE_SUN only
+	uint8_t			reserved[2];			// zero, keeps `periods` word aligned
+	period_packed_t periods[MAX_PERIODS];	// up to 6 periods per day
+} profile_t;
+
+extern period_packed_t profile_encode_period(const period_t* period);
+extern void			   profile_decode_period(period_packed_t packed, period_t* period);
+extern void			   profile_get_period(const profile_t* profile, int index, period_t* period);
+extern void			   profile_set_period(profile_t* profile, int index, const period_t* period);
+extern uint32_t		   profile_total_minutes(const profile_t* profile);
+extern void			   profile_sanitize(profile_t* profile);
+extern void			   profile_encode(const profile_t* profile, uint8_t* record);
+extern bool			   profile_decode(const uint8_t* record, profile_t* profile);
+
+#endif // PROFILE_H
@@ -0,0 +1,294 @@
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "flow_meter.pio.h"
+#include "pins.h"
+#include "power.h"
+#include "outputs.h"
+#include "task.h"
+#include "sensors.h"
+#include "alarms.h"
+#include "pump_monitor.h"
+
+#define FLOW_METER_PIO pio0
+#define FLOW_METER_SM  1 // sm 0 runs the quadrature encoder
+
+static uint32_t last_pulses		 = 0;	  // pulse count at the previous evaluation
+static uint32_t last_timestamp	 = 0;	  // time base value of the last pulse at the previous evaluation
+static uint32_t flow_ml_per_min	 = 0;	  // flow rate over the last evaluation period
+static uint32_t cycle_pulses	 = 0;	  // pulses since the pump was switched on
+static uint32_t last_cycle_ml	 = 0;	  // volume pumped in the last completed pump cycle
+static bool		pump_was_on		 = false; // pump state at the previous evaluation
+static uint32_t no_flow_ms		 = 0;	  // how long the running pump has produced no pulses
+static task_t	pump_monitor_task;
+
+static pump_current_window_t current_window; // pump current since the pump was switched on
+static task_t				 pump_current_task;
+
+/**
+ * @brief Computes the flow rate from the pulses and time base ticks between two pulse edges.
+ *
+ * Pure function, no hardware access.
+ *
+ * @param pulses Pulses counted between the two edges.
+ * @param ticks  Flow meter time base ticks between the two edges.
+ * @return The flow rate in ml/min, 0 if there were no pulses.
+ */
+uint32_t pump_flow_ml_per_min(uint32_t pulses, uint32_t ticks)
+{
+	if(pulses == 0 || ticks == 0)
+	{
+		return 0;
+	}
+	return (uint32_t) ((uint64_t) pulses * 60 * 1000 * FLOW_METER_TICK_HZ / ((uint64_t) ticks * FLOW_PULSES_PER_LITRE));
+}
+
+/**
+ * @brief Empties the current window, called when the pump is switched off.
+ */
+void pump_current_reset(pump_current_window_t* window)
+{
+	*window = (pump_current_window_t) {0};
+}
+
+/**
+ * @brief Returns the window average in mA with `PUMP_CURRENT_FRAC` fractional bits.
+ */
+uint32_t pump_current_average_q4(const pump_current_window_t* window)
+{
+	if(window->count == 0)
+	{
+		return 0;
+	}
+	return (window->sum << PUMP_CURRENT_FRAC) / window->count;
+}
+
+/**
+ * @brief Adds one sensor batch to the current window and checks the current signature.
+ *
+ * Batches within `PUMP_CURRENT_SETTLE_MS` of switching on are skipped so the inrush current does not
+ * count, and nothing is reported until the window is full. A fault holds until the average crosses its
+ * clear threshold (`PUMP_DRY_RUN_CLEAR_MA`, `PUMP_STALL_CLEAR_MA`), so a current hovering at a trip
+ * threshold does not toggle the alarm. Pure function, no hardware access, so it can be replayed against
+ * recorded current traces.
+ *
+ * @param window     The window, reset with `pump_current_reset()` while the pump is off.
+ * @param current_ma Mean pump current of the batch.
+ * @param elapsed_ms Time covered by the batch.
+ * @return The detected fault, PUMP_FAULT_NONE if the current looks normal.
+ */
+pump_fault_t pump_current_update(pump_current_window_t* window, uint32_t current_ma, uint32_t elapsed_ms)
+{
+	window->on_ms += elapsed_ms;
+	if(window->on_ms <= PUMP_CURRENT_SETTLE_MS)
+	{
+		return PUMP_FAULT_NONE;
+	}
+
+	if(current_ma > 0xFFFF)
+	{
+		current_ma = 0xFFFF;
+	}
+	if(window->count == PUMP_CURRENT_WINDOW)
+	{
+		window->sum -= window->samples[window->next];
+	} else
+	{
+		window->count++;
+	}
+	window->samples[window->next]  = current_ma;
+	window->sum					  += current_ma;
+	window->next				   = (window->next + 1) & (PUMP_CURRENT_WINDOW - 1);
+
+	if(window->count < PUMP_CURRENT_WINDOW)
+	{
+		return PUMP_FAULT_NONE;
+	}
+	uint32_t average = pump_current_average_q4(window);
+	if(window->fault == PUMP_FAULT_DRY_RUN && average < (PUMP_DRY_RUN_CLEAR_MA << PUMP_CURRENT_FRAC))
+	{
+		return PUMP_FAULT_DRY_RUN;
+	}
+	if(window->fault == PUMP_FAULT_STALL && average > (PUMP_STALL_CLEAR_MA << PUMP_CURRENT_FRAC))
+	{
+		return PUMP_FAULT_STALL;
+	}
+	if(average < (PUMP_DRY_RUN_MA << PUMP_CURRENT_FRAC))
+	{
+		window->fault = PUMP_FAULT_DRY_RUN;
+	} else if(average > (PUMP_STALL_MA << PUMP_CURRENT_FRAC))
+	{
+		window->fault = PUMP_FAULT_STALL;
+	} else
+	{
+		window->fault = PUMP_FAULT_NONE;
+	}
+	return window->fault;
+}
+
+/**
+ * @brief Keeps the flow meter time base at `FLOW_METER_TICK_HZ` across system clock changes.
+ *
+ * @param sys_hz The new system clock frequency in Hz.
+ */
+static void pump_monitor_on_clock_change(uint32_t sys_hz)
+{
+	uint32_t div256 = (uint32_t) ((uint64_t) sys_hz * 256 / (FLOW_METER_TICK_HZ * FLOW_METER_CYCLES_PER_TICK));
+	pio_sm_set_clkdiv_int_frac(FLOW_METER_PIO, FLOW_METER_SM, div256 >> 8, div256 & 0xFF);
+}
+
+/**
+ * @brief Reads the flow meter totals and updates the flow rate, the cycle volume and the no-flow alarm.
+ */
+static void pump_monitor_update()
+{
+	uint32_t pulses;
+	uint32_t timestamp;
+	flow_meter_read(FLOW_METER_PIO, FLOW_METER_SM, &pulses, &timestamp);
+
+	uint32_t new_pulses = pulses - last_pulses;
+	if(new_pulses == 0)
+	{
+		flow_ml_per_min = 0;
+	} else if(flow_ml_per_min == 0)
+	{
+		// The previous edge timestamp is stale (or has wrapped), estimate from the period length instead
+		flow_ml_per_min = new_pulses * (60000 / PUMP_MONITOR_PERIOD_MS) * 1000 / FLOW_PULSES_PER_LITRE;
+	} else
+	{
+		flow_ml_per_min = pump_flow_ml_per_min(new_pulses, timestamp - last_timestamp);
+	}
+	last_pulses	   = pulses;
+	last_timestamp = timestamp;
+
+	bool pump_on   = outputs_pump_is_on();
+	if(pump_on)
+	{
+		if(!pump_was_on)
+		{
+			cycle_pulses = 0;
+			no_flow_ms	 = 0;
+		} else
+		{
+			cycle_pulses += new_pulses;
+			no_flow_ms	  = new_pulses ? 0 : no_flow_ms + PUMP_MONITOR_PERIOD_MS;
+		}
+		alarms_set(ALARM_PUMP_NO_FLOW, PUMP_FLOW_SENSOR && no_flow_ms >= PUMP_NO_FLOW_GRACE_MS);
+	} else
+	{
+		if(pump_was_on)
+		{
+			cycle_pulses  += new_pulses; // flow that was still running down
+			last_cycle_ml  = cycle_pulses * 1000 / FLOW_PULSES_PER_LITRE;
+		}
+		alarms_set(ALARM_PUMP_NO_FLOW, false);
+	}
+	pump_was_on = pump_on;
+}
+
+/**
+ * @brief Evaluates the flow meter every `PUMP_MONITOR_PERIOD_MS`.
+ */
+static task_status_t pump_monitor_task_fn(task_t* task)
+{
+	TASK_BEGIN(task);
+	while(true)
+	{
+		TASK_SLEEP_MS(task, PUMP_MONITOR_PERIOD_MS);
+		pump_monitor_update();
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Checks the pump current after every sensor batch while the pump is commanded on.
+ *
+ * The ADC samples the current sense input continuously (it shares the DMA ring with the temperature
+ * sensor), but the batches are only consumed while the pump is on; the window restarts at every
+ * switch-on.
+ */
+static task_status_t pump_current_task_fn(task_t* task)
+{
+	TASK_BEGIN(task);
+	while(true)
+	{
+		TASK_WAIT_EVENT(task, SENSOR_EVENT_BATCH);
+
+		if(!outputs_pump_is_on())
+		{
+			pump_current_reset(&current_window);
+			alarms_set(ALARM_PUMP_DRY_RUN, false);
+			alarms_set(ALARM_PUMP_STALL, false);
+			continue;
+		}
+
+		uint32_t	 current_ma = sensors_batch_mv(SENSOR_PUMP_CURRENT) * 1000 / PUMP_CURRENT_MV_PER_A;
+		pump_fault_t fault		= pump_current_update(&current_window, current_ma, SENSOR_PERIOD_MS);
+		alarms_set(ALARM_PUMP_DRY_RUN, fault == PUMP_FAULT_DRY_RUN);
+		alarms_set(ALARM_PUMP_STALL, fault == PUMP_FAULT_STALL);
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Starts the flow meter state machine next to the quadrature encoder on pio0.
+ *
+ * The PIO counts the pulses and timestamps the last one; the CPU only reads the totals once per
+ * `PUMP_MONITOR_PERIOD_MS`. Also starts the pump current check, `sensors_init()` must run first.
+ *
+ * ALARM_PUMP_NO_FLOW is only raised with `PUMP_FLOW_SENSOR` and the current check only runs with
+ * `PUMP_CURRENT_SENSE`, see pins.h.
+ */
+void pump_monitor_init()
+{
+	uint offset = pio_add_program(FLOW_METER_PIO, &flow_meter_program);
+	flow_meter_program_init(FLOW_METER_PIO, FLOW_METER_SM, offset, PIN_FLOW_METER);
+	pump_monitor_on_clock_change(clock_get_hz(clk_sys));
+	power_add_clock_listener(pump_monitor_on_clock_change);
+
+	task_start(&pump_monitor_task, pump_monitor_task_fn);
+	if(PUMP_CURRENT_SENSE)
+	{
+		task_start(&pump_current_task, pump_current_task_fn);
+	}
+}
+
+/**
+ * @brief Returns the flow rate over the last `PUMP_MONITOR_PERIOD_MS` in ml/min.
+ */
+uint32_t pump_monitor_flow_ml_per_min()
+{
+	return flow_ml_per_min;
+}
+
+/**
+ * @brief Returns the volume pumped since the pump was last switched on, in ml.
+ */
+uint32_t pump_monitor_cycle_ml()
+{
+	return cycle_pulses * 1000 / FLOW_PULSES_PER_LITRE;
+}
+
+/**
+ * @brief Returns the volume pumped in the last completed pump cycle, in ml.
+ */
+uint32_t pump_monitor_last_cycle_ml()
+{
+	return last_cycle_ml;
+}
+
+/**
+ * @brief Returns the total number of flow meter pulses since start.
+ */
+uint32_t pump_monitor_total_pulses()
+{
+	return last_pulses;
+}
+
+/**
+ * @brief Returns the average pump current over the current window, in mA (0 while the pump is off).
+ */
+uint32_t pump_monitor_current_ma()
+{
+	return pump_current_average_q4(&current_window) >> PUMP_CURRENT_FRAC;
+}
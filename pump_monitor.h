@@ -0,0 +1,82 @@
+#ifndef PUMP_MONITOR_H
+#define PUMP_MONITOR_H
+
+#include "pico/stdlib.h"
+#include "alarms.h"
+
+#define PUMP_MONITOR_PERIOD_MS	1000   // flow evaluation period
+#define FLOW_METER_TICK_HZ		500000 // flow meter PIO time base rate
+#define FLOW_PULSES_PER_LITRE	450	   // flow sensor constant (YF-S201: 7.5 Hz per l/min)
+#define PUMP_NO_FLOW_GRACE_MS	5000   // pump may run this long without pulses before ALARM_PUMP_NO_FLOW
+
+#define PUMP_CURRENT_MV_PER_A		1000 // current sense gain (shunt resistance x amplifier gain)
+#define PUMP_CURRENT_WINDOW_BITS	3	 // averaging window of 2^3 sensor batches (2 s)
+#define PUMP_CURRENT_WINDOW			(1 << PUMP_CURRENT_WINDOW_BITS)
+#define PUMP_CURRENT_FRAC			4	 // fractional bits of the window average
+#define PUMP_CURRENT_SETTLE_MS		1000 // inrush current after switching on is ignored this long
+#define PUMP_DRY_RUN_MA				150	 // average below this: unloaded pump (dry run) or open circuit
+#define PUMP_DRY_RUN_CLEAR_MA		200	 // ... and at or above this the dry run is over
+#define PUMP_STALL_MA				1500 // average above this: stalled rotor
+#define PUMP_STALL_CLEAR_MA			1300 // ... and at or below this the rotor turns again
+
+/**
+ * @brief Alarms that switch the pump off until they are cleared from the menu.
+ */
+#define PUMP_LOCKOUT_ALARMS (ALARM_BIT(ALARM_PUMP_DRY_RUN) | ALARM_BIT(ALARM_PUMP_STALL))
+
+/**
+ * @enum pump_fault_t
+ * @brief Result of the pump current signature check.
+ *
+ * - PUMP_FAULT_NONE:    Current within the normal range, or not enough data yet.
+ * - PUMP_FAULT_DRY_RUN: Current too low for a loaded pump.
+ * - PUMP_FAULT_STALL:   Current too high, the rotor is blocked.
+ */
+typedef enum
+{
+	PUMP_FAULT_NONE,
+	PUMP_FAULT_DRY_RUN,
+	PUMP_FAULT_STALL
+} pump_fault_t;
+
+/**
+ * @struct pump_current_window_t
+ * @brief Moving window over the pump current of the last `PUMP_CURRENT_WINDOW` sensor batches.
+ *
+ * @var pump_current_window_t::samples
+ *   Batch currents in mA, oldest overwritten first.
+ * @var pump_current_window_t::sum
+ *   Sum of `samples`.
+ * @var pump_current_window_t::count
+ *   Number of valid samples, the window is only judged once it is full.
+ * @var pump_current_window_t::next
+ *   Slot the next sample is written to.
+ * @var pump_current_window_t::on_ms
+ *   Time since the pump was switched on.
+ * @var pump_current_window_t::fault
+ *   Fault reported by the last update, it holds until the average is back past its clear threshold.
+ */
+typedef struct
+{
+	uint16_t	 samples[PUMP_CURRENT_WINDOW];
+	uint32_t	 sum;
+	uint8_t		 count;
+	uint8_t		 next;
+	uint32_t	 on_ms;
+	pump_fault_t fault;
+} pump_current_window_t;
+
+extern void		pump_monitor_init();
+extern uint32_t pump_monitor_flow_ml_per_min();
+extern uint32_t pump_monitor_cycle_ml();
+extern uint32_t pump_monitor_last_cycle_ml();
+extern uint32_t pump_monitor_total_pulses();
+extern uint32_t pump_monitor_current_ma();
+
+extern void			pump_current_reset(pump_current_window_t* window);
+extern pump_fault_t pump_current_update(pump_current_window_t* window, uint32_t current_ma, uint32_t elapsed_ms);
+extern uint32_t		pump_current_average_q4(const pump_current_window_t* window);
+
+extern uint32_t pump_flow_ml_per_min(uint32_t pulses, uint32_t ticks);
+
+#endif // PUMP_MONITOR_H
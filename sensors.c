@@ -0,0 +1,339 @@
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "pins.h"
+#include "task.h"
+#include "alarms.h"
+#include "sensors.h"
+
+#define SENSOR_RING_SAMPLES ((1u << SENSOR_RING_BITS) / sizeof(uint16_t))
+#define SENSOR_RING_MARGIN	32 // samples next to the DMA write position that are never read, they may be overwritten
+
+/**
+ * @struct sensor_threshold_t
+ * @brief A threshold alarm with hysteresis on a filtered sensor voltage.
+ *
+ * The alarm is raised when the voltage crosses `trip_mv` and cleared when it crosses back over `clear_mv`.
+ * `trip_mv` above `clear_mv` makes a high alarm, below makes a low alarm.
+ */
+typedef struct
+{
+	sensor_t	sensor;
+	alarms_id_t alarm;
+	uint32_t	trip_mv;
+	uint32_t	clear_mv;
+} sensor_threshold_t;
+
+static const uint sensor_inputs[SENSOR_COUNT] = {
+#define SENSOR_INPUT(sensor, input) [sensor] = input,
+	SENSOR_LIST(SENSOR_INPUT)
+#undef SENSOR_INPUT
+};
+
+static const sensor_threshold_t sensor_thresholds[] = {
+#if PUMP_CURRENT_SENSE
+	{SENSOR_PUMP_CURRENT, ALARM_PUMP_OVERCURRENT, SENSOR_PUMP_CURRENT_TRIP_MV, SENSOR_PUMP_CURRENT_CLEAR_MV},
+#endif
+	{SENSOR_CHIP_TEMP,	  ALARM_CHIP_OVERTEMP,	  SENSOR_CHIP_HOT_TRIP_MV,	   SENSOR_CHIP_HOT_CLEAR_MV	   },
+};
+
+static uint16_t		  sample_ring[SENSOR_RING_SAMPLES] __attribute__((aligned(1u << SENSOR_RING_BITS)));
+static const uint32_t ring_count = SENSOR_RING_SAMPLES; // reload value the control channel writes
+
+static int				 dma_chan;		  // writes the ADC FIFO into the ring
+static int				 ctrl_chan;		  // re-arms `dma_chan` after every pass, chained from it
+static volatile uint32_t ring_laps	 = 0; // completed DMA passes over the ring, counted by the DMA IRQ
+static uint32_t			 processed	 = 0; // total index of the next sample to filter
+static sensor_t			 next_sensor = 0; // sensor the sample at `processed` belongs to
+static uint32_t			 overruns	 = 0; // batches that lost samples, in the ring or in the ADC FIFO
+
+static sensor_filter_t filters[SENSOR_COUNT];
+static uint32_t		   batch_mv[SENSOR_COUNT]; // unfiltered mean of the last batch
+static task_t		   sensors_task;
+
+/**
+ * @brief Feeds one batch into the filter.
+ *
+ * The batch is reduced to its mean first, so the IIR step runs once per batch instead of once per sample.
+ * Pure function, no hardware access.
+ *
+ * @param filter The filter to update.
+ * @param sum    Sum of the raw ADC samples in the batch.
+ * @param count  Number of samples in the batch, nothing happens if 0.
+ */
+void sensor_filter_update(sensor_filter_t* filter, uint32_t sum, uint32_t count)
+{
+	if(count == 0)
+	{
+		return;
+	}
+	int32_t mean = (int32_t) ((sum << SENSOR_FILTER_FRAC) / count);
+	if(!filter->primed)
+	{
+		filter->state  = mean;
+		filter->primed = true;
+		return;
+	}
+	filter->state += (mean - filter->state) >> SENSOR_FILTER_SHIFT;
+}
+
+/**
+ * @brief Returns the filtered value in ADC counts, rounded to the nearest count.
+ */
+uint16_t sensor_filter_value(const sensor_filter_t* filter)
+{
+	return (uint16_t) ((filter->state + (1 << (SENSOR_FILTER_FRAC - 1))) >> SENSOR_FILTER_FRAC);
+}
+
+/**
+ * @brief Evaluates a threshold with hysteresis. Pure function, no hardware access.
+ *
+ * @param mv       The current voltage.
+ * @param trip_mv  Voltage that raises the alarm. Above `clear_mv` for a high alarm, below for a low alarm.
+ * @param clear_mv Voltage that clears the alarm.
+ * @param active   Current alarm state.
+ * @return The new alarm state.
+ */
+bool sensor_threshold_check(uint32_t mv, uint32_t trip_mv, uint32_t clear_mv, bool active)
+{
+	if(trip_mv > clear_mv)
+	{
+		return active ? mv > clear_mv : mv >= trip_mv;
+	}
+	return active ? mv < clear_mv : mv <= trip_mv;
+}
+
+/**
+ * @brief DMA completion interrupt, counts the passes over the ring.
+ *
+ * Runs once per `SENSOR_RING_SAMPLES` samples. The transfer is restarted by `ctrl_chan`, not here, so
+ * sampling goes on while interrupts are disabled (flash writes); a late IRQ only delays the count.
+ */
+static void sensors_on_dma_irq()
+{
+	if(!dma_channel_get_irq0_status(dma_chan))
+	{
+		return;
+	}
+	dma_channel_acknowledge_irq0(dma_chan);
+	ring_laps++;
+}
+
+/**
+ * @brief Returns the total number of samples the DMA has written since start.
+ *
+ * A pass that ended while its IRQ is still pending (interrupts disabled) is counted from the raw
+ * interrupt flag, since the transfer count has already been reloaded for the next pass.
+ */
+static uint32_t sensors_samples_written()
+{
+	uint32_t laps;
+	uint32_t late;
+	uint32_t remaining;
+	do
+	{
+		laps	  = ring_laps;
+		late	  = dma_hw->intr & (1u << dma_chan);
+		remaining = dma_channel_hw_addr(dma_chan)->transfer_count;
+	} while(laps != ring_laps || late != (dma_hw->intr & (1u << dma_chan)));
+
+	return (laps + (late ? 2 : 1)) * SENSOR_RING_SAMPLES - remaining;
+}
+
+/**
+ * @brief Restarts the round-robin after the ADC FIFO overflowed.
+ *
+ * Lost conversions make the position of a sample in the ring no longer tell its input, so the ADC is
+ * stopped, the FIFO drained into the ring, the samples written so far dropped and the sequence restarted
+ * from the first input.
+ */
+static void sensors_resync()
+{
+	adc_run(false);
+	while(!(adc_hw->cs & ADC_CS_READY_BITS))
+	{
+		tight_loop_contents(); // conversion in progress
+	}
+	while(adc_fifo_get_level() > 0)
+	{
+		tight_loop_contents(); // the DMA empties the FIFO
+	}
+	processed	= sensors_samples_written();
+	next_sensor = 0;
+	adc_select_input(sensor_inputs[0]);
+	hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS); // write 1 to clear
+	adc_run(true);
+	overruns++;
+}
+
+/**
+ * @brief Filters every sample written since the last call and updates the threshold alarms.
+ *
+ * Signals `SENSOR_EVENT_BATCH` when done, so consumers of the batch means run right after. If the ADC FIFO
+ * overflowed since the last call the batch is dropped, see `sensors_resync()`.
+ */
+static void sensors_process()
+{
+	if(adc_hw->fcs & ADC_FCS_OVER_BITS)
+	{
+		sensors_resync();
+		return;
+	}
+
+	uint32_t written = sensors_samples_written();
+	uint32_t pending = written - processed;
+	if(pending > SENSOR_RING_SAMPLES - SENSOR_RING_MARGIN)
+	{
+		// Fell behind, the oldest samples are already overwritten
+		uint32_t skip = pending - (SENSOR_RING_SAMPLES - SENSOR_RING_MARGIN);
+		processed	 += skip;
+		next_sensor	  = (next_sensor + skip) % SENSOR_COUNT;
+		overruns++;
+	}
+
+	uint32_t sum[SENSOR_COUNT]	 = {0};
+	uint32_t count[SENSOR_COUNT] = {0};
+	for(; processed != written; processed++)
+	{
+		sum[next_sensor] += sample_ring[processed & (SENSOR_RING_SAMPLES - 1)];
+		count[next_sensor]++;
+		if(++next_sensor == SENSOR_COUNT)
+		{
+			next_sensor = 0;
+		}
+	}
+	for(int i = 0; i < SENSOR_COUNT; i++)
+	{
+		sensor_filter_update(&filters[i], sum[i], count[i]);
+		if(count[i])
+		{
+			batch_mv[i] = sum[i] / count[i] * SENSOR_VREF_MV >> 12;
+		}
+	}
+
+	for(int i = 0; i < count_of(sensor_thresholds); i++)
+	{
+		const sensor_threshold_t* threshold = &sensor_thresholds[i];
+		if(!filters[threshold->sensor].primed)
+		{
+			continue;
+		}
+		bool active = alarms_active() & ALARM_BIT(threshold->alarm);
+		alarms_set(threshold->alarm, sensor_threshold_check(sensors_read_mv(threshold->sensor), threshold->trip_mv,
+															threshold->clear_mv, active));
+	}
+
+	task_signal(SENSOR_EVENT_BATCH);
+}
+
+/**
+ * @brief Runs the batch filter every `SENSOR_PERIOD_MS`.
+ */
+static task_status_t sensors_task_fn(task_t* task)
+{
+	TASK_BEGIN(task);
+	while(true)
+	{
+		TASK_SLEEP_MS(task, SENSOR_PERIOD_MS);
+		sensors_process();
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Starts free-running ADC sampling into the DMA ring.
+ *
+ * The ADC converts every input of `SENSOR_LIST` round-robin at `SENSOR_SAMPLE_RATE_HZ` in total, and a
+ * DMA channel paced by the ADC FIFO writes the results into a ring buffer. At the end of each pass it chains
+ * to a control channel that reloads its transfer count and restarts it, so sampling never waits for the
+ * CPU. The CPU is only involved once per ring pass (DMA IRQ, lap count) and once per `SENSOR_PERIOD_MS`
+ * (filter task).
+ *
+ * The ADC runs from the 48 MHz USB PLL, so system clock changes do not affect the sample rate.
+ */
+void sensors_init()
+{
+	adc_init();
+	adc_gpio_init(PIN_SENSE_ADC);
+	adc_set_temp_sensor_enabled(true);
+
+	uint32_t mask = 0;
+	for(int i = 0; i < SENSOR_COUNT; i++)
+	{
+		mask |= 1u << sensor_inputs[i];
+	}
+	adc_select_input(sensor_inputs[0]);
+	adc_set_round_robin(mask);
+	adc_fifo_setup(true, true, 1, false, false);
+	adc_set_clkdiv((float) (clock_get_hz(clk_adc) / SENSOR_SAMPLE_RATE_HZ - 1));
+
+	dma_chan				 = dma_claim_unused_channel(true);
+	ctrl_chan				 = dma_claim_unused_channel(true);
+	dma_channel_config config = dma_channel_get_default_config(dma_chan);
+	channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+	channel_config_set_read_increment(&config, false);
+	channel_config_set_write_increment(&config, true);
+	channel_config_set_ring(&config, true, SENSOR_RING_BITS);
+	channel_config_set_dreq(&config, DREQ_ADC);
+	channel_config_set_chain_to(&config, ctrl_chan);
+	dma_channel_configure(dma_chan, &config, sample_ring, &adc_hw->fifo, SENSOR_RING_SAMPLES, false);
+
+	// One word into the transfer count trigger alias restarts the data channel, its write address wraps by itself
+	dma_channel_config ctrl = dma_channel_get_default_config(ctrl_chan);
+	channel_config_set_transfer_data_size(&ctrl, DMA_SIZE_32);
+	channel_config_set_read_increment(&ctrl, false);
+	channel_config_set_write_increment(&ctrl, false);
+	dma_channel_configure(ctrl_chan, &ctrl, &dma_channel_hw_addr(dma_chan)->al1_transfer_count_trig, &ring_count, 1,
+						  false);
+	dma_channel_start(dma_chan);
+
+	dma_channel_set_irq0_enabled(dma_chan, true);
+	irq_add_shared_handler(DMA_IRQ_0, sensors_on_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+	irq_set_enabled(DMA_IRQ_0, true);
+
+	adc_run(true);
+
+	task_start(&sensors_task, sensors_task_fn);
+}
+
+/**
+ * @brief Returns the filtered value of a sensor in ADC counts (0 - 4095).
+ */
+uint16_t sensors_read(sensor_t sensor)
+{
+	return sensor_filter_value(&filters[sensor]);
+}
+
+/**
+ * @brief Returns the filtered voltage of a sensor in millivolts.
+ */
+uint32_t sensors_read_mv(sensor_t sensor)
+{
+	return ((uint32_t) sensors_read(sensor) * SENSOR_VREF_MV) >> 12;
+}
+
+/**
+ * @brief Returns the unfiltered mean voltage of a sensor over the last batch, in millivolts.
+ */
+uint32_t sensors_batch_mv(sensor_t sensor)
+{
+	return batch_mv[sensor];
+}
+
+/**
+ * @brief Returns the total number of samples converted since start.
+ */
+uint32_t sensors_sample_count()
+{
+	return sensors_samples_written();
+}
+
+/**
+ * @brief Returns the number of filter batches that fell more than a ring behind.
+ */
+uint32_t sensors_overruns()
+{
+	return overruns;
+}
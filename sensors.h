@@ -0,0 +1,70 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "pico/stdlib.h"
+
+#define SENSOR_SAMPLE_RATE_HZ 1000 // ADC conversions per second, shared by all round-robin channels
+#define SENSOR_RING_BITS	  10   // DMA ring size as a power of two in bytes (512 samples)
+#define SENSOR_PERIOD_MS	  250  // filter batch period
+#define SENSOR_FILTER_FRAC	  4	   // fractional bits of the filter state
+#define SENSOR_FILTER_SHIFT	  2	   // IIR smoothing, each batch moves the output 1/4 of the way to the batch mean
+#define SENSOR_VREF_MV		  3300 // ADC reference voltage
+
+#define SENSOR_EVENT_BATCH (1u << 0) // task event signalled after every filter batch
+
+#define SENSOR_PUMP_CURRENT_TRIP_MV	 2500 // pump current sense voltage that raises ALARM_PUMP_OVERCURRENT
+#define SENSOR_PUMP_CURRENT_CLEAR_MV 2300 // ... and that clears it again
+#define SENSOR_CHIP_HOT_TRIP_MV		 623  // temperature sensor voltage at about 75 C, raises ALARM_CHIP_OVERTEMP
+#define SENSOR_CHIP_HOT_CLEAR_MV	 641  // ... about 65 C, clears it again (the voltage falls as the chip heats up)
+
+/**
+ * @brief Sampled ADC inputs: X(sensor, adc input).
+ *
+ * The ADC converts the inputs round-robin in ascending input order, so the list must be sorted by input.
+ *
+ * - SENSOR_PUMP_CURRENT: Pump current sense amplifier on `PIN_SENSE_ADC`.
+ * - SENSOR_CHIP_TEMP:    RP2040 internal temperature sensor.
+ */
+#define SENSOR_LIST(X)          \
+	X(SENSOR_PUMP_CURRENT, 0) \
+	X(SENSOR_CHIP_TEMP, 4)
+
+/**
+ * @enum sensor_t
+ * @brief Sampled ADC inputs, see `SENSOR_LIST`.
+ */
+typedef enum
+{
+#define SENSOR_ENUM(sensor, input) sensor,
+	SENSOR_LIST(SENSOR_ENUM)
+#undef SENSOR_ENUM
+	SENSOR_COUNT
+} sensor_t;
+
+/**
+ * @struct sensor_filter_t
+ * @brief Fixed-point IIR filter fed with batch means.
+ *
+ * @var sensor_filter_t::state
+ *   Filtered value in ADC counts with `SENSOR_FILTER_FRAC` fractional bits.
+ * @var sensor_filter_t::primed
+ *   false until the first batch, which loads the state directly.
+ */
+typedef struct
+{
+	int32_t state;
+	bool	primed;
+} sensor_filter_t;
+
+extern void		sensors_init();
+extern uint16_t sensors_read(sensor_t sensor);
+extern uint32_t sensors_read_mv(sensor_t sensor);
+extern uint32_t sensors_batch_mv(sensor_t sensor);
+extern uint32_t sensors_sample_count();
+extern uint32_t sensors_overruns();
+
+extern void		sensor_filter_update(sensor_filter_t* filter, uint32_t sum, uint32_t count);
+extern uint16_t sensor_filter_value(const sensor_filter_t* filter);
+extern bool		sensor_threshold_check(uint32_t mv, uint32_t trip_mv, uint32_t clear_mv, bool active);
+
+#endif // SENSORS_H
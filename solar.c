@@ -0,0 +1,116 @@
+#include "pico/stdlib.h"
+#include "solar.h"
+
+#define SOLAR_MAX_DECLINATION 4267 // 23.44 degrees as a binary angle
+#define SOLAR_HORIZON_SIN_Q15 (-476) // sin(-0.833 degrees): sunrise/sunset with refraction and the sun's radius
+
+/**
+ * @brief Quarter wave sine table, sin(i / 64 * 90 degrees) in Q15.
+ *
+ * Generated with `round(32767 * sin(pi / 2 * i / 64))` for i = 0..64.
+ */
+static const int16_t sine_table[65] = {
+	0,	   804,	  1608,	 2410,	3212,  4011,  4808,	 5602,	6393,  7179,  7962,	 8739,	9512,
+	10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868,
+	19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811, 25329, 25832, 26319,
+	26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113,
+	31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767,
+};
+
+/**
+ * @brief Fixed-point sine.
+ *
+ * Looks up the quarter wave table and interpolates linearly between entries (error below 1e-4).
+ *
+ * @param angle The angle in binary units, `SOLAR_ANGLE_TURN` per full turn (wraps).
+ * @return The sine in Q15.
+ */
+int32_t solar_sin_q15(uint32_t angle)
+{
+	uint32_t quadrant = (angle >> 14) & 3;
+	uint32_t a		  = angle & 0x3FFF;
+	if(quadrant & 1)
+	{
+		a = 0x4000 - a; // mirror the second and fourth quadrant
+	}
+	uint32_t index = a >> 8;
+	int32_t	 value = sine_table[index];
+	if(index < 64)
+	{
+		value += ((sine_table[index + 1] - value) * (int32_t) (a & 0xFF)) >> 8;
+	}
+	return quadrant & 2 ? -value : value;
+}
+
+/**
+ * @brief Fixed-point cosine, see `solar_sin_q15()`.
+ */
+int32_t solar_cos_q15(uint32_t angle)
+{
+	return solar_sin_q15(angle + SOLAR_ANGLE_TURN / 4);
+}
+
+/**
+ * @brief Fixed-point arc cosine.
+ *
+ * Binary search over the half turn where the cosine falls monotonically; 15 steps give full binary
+ * angle resolution. Meant for a few calls per day, not for inner loops.
+ *
+ * @param x_q15 The cosine in Q15, clamped to -1..1.
+ * @return The angle in binary units, 0 to `SOLAR_ANGLE_TURN / 2`.
+ */
+int32_t solar_acos(int32_t x_q15)
+{
+	uint32_t low  = 0;
+	uint32_t high = SOLAR_ANGLE_TURN / 2;
+	while(low < high)
+	{
+		uint32_t mid = (low + high) / 2;
+		if(solar_cos_q15(mid) > x_q15)
+		{
+			low = mid + 1;
+		} else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/**
+ * @brief Computes the time from sunrise to sunset.
+ *
+ * Uses the cosine declination model, declination = -23.44 * cos(360 / 365 * (day + 10)), and the sunrise
+ * equation cos(H) = (sin(h0) - sin(lat) * sin(decl)) / (cos(lat) * cos(decl)) with h0 = -0.833 degrees.
+ * Integer math only; the result is within a few minutes of an almanac for the supported latitudes.
+ *
+ * @param latitude    Latitude in degrees, north positive (-89 to 89).
+ * @param day_of_year Day of the year, 1 = January 1st.
+ * @return The day length in minutes, 0 during polar night and `SOLAR_DAY_MINUTES` during polar day.
+ */
+int solar_day_length_minutes(int latitude, int day_of_year)
+{
+	uint32_t season		 = (uint32_t) (day_of_year + 10) * SOLAR_ANGLE_TURN / SOLAR_DAYS;
+	int32_t	 declination = -(SOLAR_MAX_DECLINATION * solar_cos_q15(season)) >> 15;
+	int32_t	 phi		 = latitude * SOLAR_ANGLE_TURN / 360;
+
+	int32_t sin_product	 = (solar_sin_q15(phi) * solar_sin_q15(declination)) >> 15;
+	int32_t cos_product	 = (solar_cos_q15(phi) * solar_cos_q15(declination)) >> 15;
+	if(cos_product <= 0)
+	{
+		return sin_product > 0 ? SOLAR_DAY_MINUTES : 0;
+	}
+
+	int32_t cos_hour_angle = (SOLAR_HORIZON_SIN_Q15 - sin_product) * 32768 / cos_product;
+	if(cos_hour_angle >= 32767)
+	{
+		return 0; // sun stays below the horizon
+	}
+	if(cos_hour_angle <= -32767)
+	{
+		return SOLAR_DAY_MINUTES; // sun stays above the horizon
+	}
+
+	// Day length is twice the hour angle, a full turn of hour angle being one day
+	return (int) ((uint32_t) solar_acos(cos_hour_angle) * 2 * SOLAR_DAY_MINUTES / SOLAR_ANGLE_TURN);
+}
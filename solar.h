@@ -0,0 +1,15 @@
+#ifndef SOLAR_H
+#define SOLAR_H
+
+#include "pico/stdlib.h"
+
+#define SOLAR_ANGLE_TURN  65536 // binary angle units per full turn
+#define SOLAR_DAYS		  365	// days per year used by the declination model
+#define SOLAR_DAY_MINUTES 1440	// minutes per day
+
+extern int32_t solar_sin_q15(uint32_t angle);
+extern int32_t solar_cos_q15(uint32_t angle);
+extern int32_t solar_acos(int32_t x_q15);
+extern int	   solar_day_length_minutes(int latitude, int day_of_year);
+
+#endif // SOLAR_H
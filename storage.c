@@ -0,0 +1,944 @@
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "crc.h"
+#include "task.h"
+#include "storage.h"
+
+static_assert(STORAGE_MAX_PROFILES * sizeof(storage_entry_t) <= STORAGE_INDEX_SECTORS * FLASH_SECTOR_SIZE,
+			  "the index does not fit its sectors");
+static_assert(STORAGE_MAX_PROFILES * PROFILE_RECORD_SIZE <= STORAGE_RECORD_SECTORS * FLASH_SECTOR_SIZE,
+			  "the records do not fit their sectors");
+static_assert(FLASH_PAGE_SIZE % sizeof(storage_entry_t) == 0, "index entries must not straddle a page");
+static_assert(FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE <= 32, "the page mask of a sector must fit a word");
+
+#define STORAGE_XIP(offset)	 ((const void*) (XIP_BASE + (offset))) // read pointer of a flash offset
+#define STORAGE_SECTOR_PAGES (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)	   // program pages per sector
+#define STORAGE_NO_SECTOR	 0xFFFFFFFF							   // `storage_writer_t::sector` of an idle writer
+
+/**
+ * @struct storage_writer_t
+ * @brief A write to the library carried out one flash operation at a time, see `storage_writer_step()`.
+ * The sector being updated is staged in `sector_buffer`.
+ */
+typedef struct
+{
+	const uint8_t* src;	   // data not staged yet
+	uint32_t	   offset; // flash offset of `src`
+	uint32_t	   size;   // bytes of `src` not staged yet
+	uint32_t	   sector; // flash offset of the sector staged in `sector_buffer`, STORAGE_NO_SECTOR if none
+	uint32_t	   pages;  // pages of that sector still to program, bit n for page n
+	bool		   erase;  // that sector still has to be erased
+	uint32_t	   crc;	   // CRC-32 of `sector_buffer`, compared with flash once the sector is done
+	bool		   ok;	   // every sector done so far verified
+} storage_writer_t;
+
+static storage_header_t header;				 // RAM copy of the header, count 0 while unformatted
+static int				header_copy		= 0; // header copy `header` was read from or last written to
+static uint32_t			erase_count		= 0; // sectors erased since boot
+static uint32_t			program_bytes	= 0; // bytes programmed since boot
+static uint32_t			skipped_sectors = 0; // sector writes dropped because flash already held the data
+
+static uint16_t sector_erases[STORAGE_SECTORS]; // erases of each library sector since boot, lowest sector first
+
+static task_t			deferred_task;			  // writes a deferred save one flash operation per step
+static profile_t		deferred_profile;		  // latest profile handed to `storage_save_deferred()`
+static int				deferred_index	 = -1;	  // profile index of `deferred_profile`, -1 if none is pending
+static bool				deferred_restart = false; // a newer save arrived while the task was between its writes
+static int				entry_index		 = -1;	  // profile whose record the task writes or wrote, its entry is due
+static profile_t		entry_profile;			  // profile being written by the task
+static uint8_t			entry_record[PROFILE_RECORD_SIZE]; // `entry_profile` encoded
+static storage_writer_t	deferred_writer = {.sector = STORAGE_NO_SECTOR}; // write of the task in progress
+
+static uint8_t sector_buffer[FLASH_SECTOR_SIZE] __attribute__((aligned(4))); // staging buffer for sector writes
+
+static bool storage_writer_step(storage_writer_t* w);
+
+/**
+ * @brief Finishes the sector the deferred save is updating, so that flash reads see it whole and
+ * `sector_buffer` is free for another write.
+ */
+static void storage_settle()
+{
+	while(deferred_writer.sector != STORAGE_NO_SECTOR)
+	{
+		storage_writer_step(&deferred_writer);
+	}
+}
+
+/**
+ * @brief Returns the index entry of a profile, read in place from flash.
+ */
+static const storage_entry_t* storage_entry(int index)
+{
+	storage_settle();
+	return (const storage_entry_t*) STORAGE_XIP(STORAGE_INDEX_OFFSET + index * sizeof(storage_entry_t));
+}
+
+/**
+ * @brief Returns the flash offset of the record slot of a profile.
+ */
+static uint32_t storage_record_offset(int index)
+{
+	return STORAGE_RECORD_OFFSET + index * PROFILE_RECORD_SIZE;
+}
+
+/**
+ * @brief Returns the record of a profile, read in place from flash.
+ *
+ * The slot is computed from the index, never taken from the `offset` of the entry, so an erased or
+ * damaged entry cannot point the read outside the record area.
+ */
+static const uint8_t* storage_record(int index)
+{
+	storage_settle();
+	return STORAGE_XIP(storage_record_offset(index));
+}
+
+/**
+ * @brief Returns a mask of the pages of `sector_buffer` that differ from flash, bit n for page n.
+ *
+ * @param sector Flash offset of the sector.
+ * @param erase  Set if a bit has to go from 0 to 1, which NOR flash can only do by erasing the sector.
+ */
+static uint32_t storage_changed_pages(uint32_t sector, bool* erase)
+{
+	const uint32_t* old	 = STORAGE_XIP(sector);
+	const uint32_t* new	 = (const uint32_t*) sector_buffer;
+	uint32_t		mask = 0;
+	*erase				 = false;
+	for(int i = 0; i < FLASH_SECTOR_SIZE / 4; i++)
+	{
+		if(old[i] != new[i])
+		{
+			mask   |= 1u << (i * 4 / FLASH_PAGE_SIZE);
+			*erase |= (new[i] & ~old[i]) != 0;
+		}
+	}
+	return mask;
+}
+
+/**
+ * @brief Returns a mask of the pages of `sector_buffer` that are not blank (all 0xFF), bit n for page n.
+ */
+static uint32_t storage_used_pages()
+{
+	const uint32_t* words = (const uint32_t*) sector_buffer;
+	uint32_t		mask  = 0;
+	for(int i = 0; i < FLASH_SECTOR_SIZE / 4; i++)
+	{
+		if(words[i] != 0xFFFFFFFF)
+		{
+			mask |= 1u << (i * 4 / FLASH_PAGE_SIZE);
+		}
+	}
+	return mask;
+}
+
+/**
+ * @brief Stages `sector_buffer` as the next sector of a write, with as little flash wear as possible.
+ *
+ * - Nothing is written if the sector already holds the new contents.
+ * - If the change only clears bits, the changed pages are programmed over the old contents without an erase.
+ * - Otherwise the sector is erased and only the pages that are not blank are programmed.
+ *
+ * @param w      The write.
+ * @param sector Flash offset of the sector.
+ */
+static void storage_writer_load(storage_writer_t* w, uint32_t sector)
+{
+	bool	 erase;
+	uint32_t pages = storage_changed_pages(sector, &erase);
+	if(pages == 0)
+	{
+		skipped_sectors++;
+		return;
+	}
+	w->sector = sector;
+	w->erase  = erase;
+	w->pages  = erase ? storage_used_pages() : pages;
+	w->crc	  = crc32(sector_buffer, FLASH_SECTOR_SIZE);
+}
+
+/**
+ * @brief Starts a write of data at any flash offset of the library, carried out by `storage_writer_step()`.
+ */
+static void storage_writer_start(storage_writer_t* w, uint32_t offset, const void* data, uint32_t size)
+{
+	*w = (storage_writer_t) {.src = data, .offset = offset, .size = size, .sector = STORAGE_NO_SECTOR, .ok = true};
+}
+
+/**
+ * @brief Carries out the next flash operation of a write: a sector erase or the program of a run of
+ * adjacent pages.
+ *
+ * Every sector the data touches is read into `sector_buffer`, patched and staged with
+ * `storage_writer_load()`, so the rest of the sector is preserved and unchanged pages are not rewritten.
+ * Interrupts are disabled for each operation only, since XIP reads (and with them any code in flash)
+ * stall while the flash is busy. Once a sector is done it is verified by comparing the CRC of the sector
+ * read back through XIP with the CRC of the buffer.
+ *
+ * @param w The write.
+ * @return false if there was nothing left to do.
+ */
+static bool storage_writer_step(storage_writer_t* w)
+{
+	while(w->sector == STORAGE_NO_SECTOR)
+	{
+		if(w->size == 0)
+		{
+			return false;
+		}
+		uint32_t sector = w->offset & ~(FLASH_SECTOR_SIZE - 1);
+		uint32_t start	= w->offset - sector;
+		uint32_t chunk	= MIN(w->size, FLASH_SECTOR_SIZE - start);
+		memcpy(sector_buffer, STORAGE_XIP(sector), FLASH_SECTOR_SIZE);
+		memcpy(sector_buffer + start, w->src, chunk);
+		w->src	  += chunk;
+		w->offset += chunk;
+		w->size	  -= chunk;
+		storage_writer_load(w, sector);
+	}
+
+	if(w->erase)
+	{
+		uint32_t ints = save_and_disable_interrupts();
+		flash_range_erase(w->sector, FLASH_SECTOR_SIZE);
+		restore_interrupts(ints);
+		erase_count++;
+		if(w->sector >= STORAGE_BASE_OFFSET && w->sector < STORAGE_LEGACY_OFFSET)
+		{
+			sector_erases[(w->sector - STORAGE_BASE_OFFSET) / FLASH_SECTOR_SIZE]++;
+		}
+		w->erase = false;
+	} else if(w->pages != 0)
+	{
+		int first = 0;
+		while(!(w->pages & (1u << first)))
+		{
+			first++;
+		}
+		int last = first;
+		while(last + 1 < STORAGE_SECTOR_PAGES && (w->pages & (1u << (last + 1))))
+		{
+			last++;
+		}
+		// one program call per run of adjacent pages
+		uint32_t size = (last - first + 1) * FLASH_PAGE_SIZE;
+		uint32_t ints = save_and_disable_interrupts();
+		flash_range_program(w->sector + first * FLASH_PAGE_SIZE, sector_buffer + first * FLASH_PAGE_SIZE, size);
+		restore_interrupts(ints);
+		program_bytes += size;
+		w->pages	  &= ~(((2u << last) - 1) & ~((1u << first) - 1));
+	}
+
+	if(!w->erase && w->pages == 0)
+	{
+		w->ok	  &= crc32(STORAGE_XIP(w->sector), FLASH_SECTOR_SIZE) == w->crc;
+		w->sector  = STORAGE_NO_SECTOR;
+	}
+	return true;
+}
+
+/**
+ * @brief Brings a sector to the contents of `sector_buffer` right away, see `storage_writer_load()`.
+ * Callers fill the buffer after `storage_settle()`.
+ *
+ * @param sector Flash offset of the sector.
+ * @return true if the sector reads back as intended.
+ */
+static bool storage_update_sector(uint32_t sector)
+{
+	storage_writer_t w;
+	storage_writer_start(&w, sector, NULL, 0);
+	storage_writer_load(&w, sector);
+	while(storage_writer_step(&w))
+	{
+		// one flash operation per call
+	}
+	return w.ok;
+}
+
+/**
+ * @brief Writes data at any flash offset of the library right away, see `storage_writer_step()`.
+ *
+ * A sector the deferred save has half written is finished first, since it occupies `sector_buffer`.
+ *
+ * @param offset Flash offset to write at.
+ * @param data   The data to write.
+ * @param size   Length of the data in bytes.
+ * @return true if every sector verified.
+ */
+static bool storage_write(uint32_t offset, const void* data, uint32_t size)
+{
+	storage_settle();
+	storage_writer_t w;
+	storage_writer_start(&w, offset, data, size);
+	while(storage_writer_step(&w))
+	{
+		// one flash operation per call
+	}
+	return w.ok;
+}
+
+/**
+ * @brief Returns the CRC of the header fields in front of `crc`.
+ */
+static uint32_t storage_header_crc(const storage_header_t* h)
+{
+	return crc32(h, offsetof(storage_header_t, crc));
+}
+
+/**
+ * @brief Returns the flash offset of a header copy.
+ */
+static uint32_t storage_header_offset(int copy)
+{
+	return STORAGE_HEADER_OFFSET - copy * FLASH_SECTOR_SIZE;
+}
+
+/**
+ * @brief Reads a header copy and checks it.
+ *
+ * @param copy Header copy.
+ * @param h    Receives the header.
+ * @return true if the copy holds a valid header of the current version.
+ */
+static bool storage_read_header(int copy, storage_header_t* h)
+{
+	memcpy(h, STORAGE_XIP(storage_header_offset(copy)), sizeof(*h));
+	return h->magic == STORAGE_MAGIC && h->version == STORAGE_VERSION && h->crc == storage_header_crc(h) &&
+		   h->count > 0 && h->count <= STORAGE_MAX_PROFILES;
+}
+
+/**
+ * @brief Writes the RAM header to flash, in the current version.
+ *
+ * The header goes to the older copy with the next sequence number; the newer copy stays untouched, so
+ * a power cut during the write falls back to it. Only a verified write makes the written copy current,
+ * so after a failed write the next one retries the same copy.
+ *
+ * @return true if the write verified.
+ */
+static bool storage_write_header()
+{
+	int copy		= (header_copy + 1) % STORAGE_HEADER_COPIES;
+	header.magic	= STORAGE_MAGIC;
+	header.version	= STORAGE_VERSION;
+	header.sequence++;
+	header.crc		= storage_header_crc(&header);
+	if(!storage_write(storage_header_offset(copy), &header, sizeof(header)))
+	{
+		return false;
+	}
+	header_copy = copy;
+	return true;
+}
+
+/**
+ * @brief Writes an encoded record to the slot of a profile.
+ *
+ * @return true if the write verified.
+ */
+static bool storage_write_record(int index, const uint8_t* record)
+{
+	return storage_write(storage_record_offset(index), record, PROFILE_RECORD_SIZE);
+}
+
+/**
+ * @brief Fills the index entry of a profile, naming its record and holding the record CRC.
+ *
+ * @param entry   The entry, reserved bytes already erased (0xFF).
+ * @param index   Profile index.
+ * @param profile The profile, for its name.
+ * @param record  The profile encoded with `profile_encode()`.
+ */
+static void storage_fill_entry(storage_entry_t* entry, int index, const profile_t* profile, const uint8_t* record)
+{
+	memcpy(entry->name, profile->name, sizeof(entry->name));
+	entry->offset = storage_record_offset(index);
+	entry->crc	  = crc32(record, PROFILE_RECORD_SIZE);
+}
+
+/**
+ * @brief Writes the index entry of a profile.
+ *
+ * @return true if the write verified.
+ */
+static bool storage_write_entry(int index, const profile_t* profile, const uint8_t* record)
+{
+	storage_entry_t entry;
+	memset(&entry, 0xFF, sizeof(entry));
+	storage_fill_entry(&entry, index, profile, record);
+	return storage_write(STORAGE_INDEX_OFFSET + index * sizeof(entry), &entry, sizeof(entry));
+}
+
+/**
+ * @brief Encodes a profile and writes its record and then its index entry.
+ *
+ * @param index   Profile index.
+ * @param profile The profile.
+ * @return true if both writes verified.
+ */
+static bool storage_write_profile(int index, const profile_t* profile)
+{
+	uint8_t record[PROFILE_RECORD_SIZE];
+	profile_encode(profile, record);
+	return storage_write_record(index, record) && storage_write_entry(index, profile, record);
+}
+
+/**
+ * @brief Checks whether the library already holds an encoded record at the given index, with its CRC.
+ */
+static bool storage_is_saved(int index, const uint8_t* record)
+{
+	return memcmp(storage_record(index), record, PROFILE_RECORD_SIZE) == 0 &&
+		   storage_entry(index)->crc == crc32(record, PROFILE_RECORD_SIZE);
+}
+
+/**
+ * @brief Drops a pending deferred save that a synchronous write supersedes.
+ *
+ * @param index Profile index written synchronously, -1 for the whole library.
+ */
+static void storage_cancel_deferred(int index)
+{
+	if(index < 0 || index == deferred_index)
+	{
+		deferred_index = -1;
+	}
+	if(index < 0 || index == entry_index)
+	{
+		storage_settle();
+		deferred_writer.size = 0; // the synchronous write covers the rest of the record and the entry
+		entry_index			 = -1;
+	}
+}
+
+/**
+ * @brief Checks whether the index entry of a profile is intact: it names its own record slot and its
+ * name is terminated. An entry erased or cut short by a power loss fails this.
+ */
+static bool storage_entry_intact(int index)
+{
+	const storage_entry_t* entry = storage_entry(index);
+	return entry->offset == storage_record_offset(index) && memchr(entry->name, 0, sizeof(entry->name)) != NULL;
+}
+
+/**
+ * @brief Counts the profiles of a library whose header copies are both lost: the leading slots that hold
+ * an intact index entry or a record that decodes. `storage_format()` leaves every slot after the last
+ * profile erased, and `storage_add()` writes a slot before the header that counts it.
+ */
+static int storage_count_slots()
+{
+	int count = 0;
+	while(count < STORAGE_MAX_PROFILES)
+	{
+		profile_t profile;
+		if(!storage_entry_intact(count) && !profile_decode(storage_record(count), &profile))
+		{
+			break;
+		}
+		count++;
+	}
+	return count;
+}
+
+/**
+ * @brief Rebuilds the index entries that are not intact from their records.
+ *
+ * An index sector is erased and reprogrammed when one of its entries changes, so a power cut at that
+ * moment loses up to a sector of entries. Everything in an entry can be derived from the record, which
+ * lives in another sector and was written before the entry. Records that do not decode are left alone,
+ * `storage_load()` reports them by their CRC.
+ */
+static void storage_repair_index()
+{
+	const int per_sector = FLASH_SECTOR_SIZE / sizeof(storage_entry_t);
+	storage_settle();
+	for(int sector = 0; sector * per_sector < header.count; sector++)
+	{
+		storage_entry_t* entries  = (storage_entry_t*) sector_buffer;
+		bool			 repaired = false;
+		memcpy(sector_buffer, STORAGE_XIP(STORAGE_INDEX_OFFSET + sector * FLASH_SECTOR_SIZE), FLASH_SECTOR_SIZE);
+		for(int i = 0; i < per_sector && sector * per_sector + i < header.count; i++)
+		{
+			int		  index = sector * per_sector + i;
+			profile_t profile;
+			if(storage_entry_intact(index) || !profile_decode(storage_record(index), &profile))
+			{
+				continue;
+			}
+			memset(&entries[i], 0xFF, sizeof(entries[i]));
+			storage_fill_entry(&entries[i], index, &profile, storage_record(index));
+			repaired = true;
+		}
+		if(repaired)
+		{
+			storage_update_sector(STORAGE_INDEX_OFFSET + sector * FLASH_SECTOR_SIZE);
+		}
+	}
+}
+
+/**
+ * @brief Reads and checks the library header.
+ *
+ * - The valid header copy with the newer sequence number is used, see `storage_write_header()`.
+ * - If neither copy is valid but the index or the record area still holds profiles, the header is
+ *   rebuilt from them instead of treating the library as empty. The first profile becomes current.
+ * - Index entries lost to a cut index write are rebuilt from their records, see `storage_repair_index()`.
+ *
+ * A rebuilt header is written right away, a single header write.
+ *
+ * @return true if the library holds profiles, false if it is empty and has to be formatted with
+ * `storage_format()`.
+ */
+bool storage_init()
+{
+	storage_header_t copies[STORAGE_HEADER_COPIES];
+	header_copy = -1;
+	for(int copy = 0; copy < STORAGE_HEADER_COPIES; copy++)
+	{
+		if(storage_read_header(copy, &copies[copy]) &&
+		   (header_copy < 0 || (int16_t) (copies[copy].sequence - copies[header_copy].sequence) > 0))
+		{
+			header_copy = copy;
+		}
+	}
+
+	if(header_copy >= 0)
+	{
+		header = copies[header_copy];
+	} else
+	{
+		header_copy = 0;
+		memset(&header, 0, sizeof(header));
+		header.count = storage_count_slots();
+		if(header.count == 0)
+		{
+			return false;
+		}
+	}
+	if(header.current >= header.count)
+	{
+		header.current = 0;
+	}
+	storage_repair_index();
+	if(header.version != STORAGE_VERSION) // rebuilt
+	{
+		storage_write_header();
+	}
+	return true;
+}
+
+/**
+ * @brief Reads a little-endian 32-bit value of a legacy save.
+ */
+static int32_t storage_legacy_int(const uint8_t* data)
+{
+	return (int32_t) (data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24));
+}
+
+/**
+ * @brief Reads a profile of the legacy save: `name[16]` and MAX_PERIODS periods of three ints each.
+ *
+ * @param data    Start of the profile in the legacy sector.
+ * @param profile Receives the profile, sanitized.
+ */
+static void storage_legacy_profile(const uint8_t* data, profile_t* profile)
+{
+	memset(profile, 0, sizeof(*profile));
+	memcpy(profile->name, data, PROFILE_NAME_LEN - 1); // names of up to 15 characters are cut to fit
+	data += 16;
+	for(int i = 0; i < MAX_PERIODS; i++, data += 12)
+	{
+		period_t period = {
+			.duration			 = storage_legacy_int(data),
+			.led_white_red_power = storage_legacy_int(data + 4),
+			.led_blue_power		 = storage_legacy_int(data + 8),
+		};
+		profile_set_period(profile, i, &period);
+	}
+	profile_sanitize(profile);
+}
+
+/**
+ * @brief Reads the profiles that firmware before the library saved in the last flash sector.
+ *
+ * The save starts with 0xA5 0x5A 0xA5 0x5A, followed by the current profile index as a little-endian int
+ * and `STORAGE_LEGACY_PROFILES` profiles of `name[16]` and 6 periods of three ints (88 bytes each). Every
+ * field is decoded explicitly, the layout is not read through a struct.
+ *
+ * @param profiles Receives `STORAGE_LEGACY_PROFILES` profiles.
+ * @param current  Receives the index of the profile that was in use.
+ * @return The number of profiles read, 0 if the sector holds no legacy save.
+ */
+int storage_read_legacy(profile_t* profiles, int* current)
+{
+	const uint8_t* legacy = STORAGE_XIP(STORAGE_LEGACY_OFFSET);
+	if(legacy[0] != 0xA5 || legacy[1] != 0x5A || legacy[2] != 0xA5 || legacy[3] != 0x5A)
+	{
+		return 0;
+	}
+	for(int i = 0; i < STORAGE_LEGACY_PROFILES; i++)
+	{
+		storage_legacy_profile(legacy + 8 + i * 88, &profiles[i]);
+	}
+	*current = storage_legacy_int(legacy + 4);
+	return STORAGE_LEGACY_PROFILES;
+}
+
+/**
+ * @brief Fills `sector_buffer` with the records of one record sector. Slots past `count` stay erased.
+ *
+ * Records do not align to sectors, so the first and last record of a sector may be cut.
+ *
+ * @param sector   Sector number within the record area.
+ * @param profiles The profiles of the library.
+ * @param count    Number of profiles.
+ */
+static void storage_fill_records(int sector, const profile_t* profiles, int count)
+{
+	int start = sector * FLASH_SECTOR_SIZE;
+	memset(sector_buffer, 0xFF, sizeof(sector_buffer));
+	for(int i = start / PROFILE_RECORD_SIZE; i < count && i * PROFILE_RECORD_SIZE < start + FLASH_SECTOR_SIZE; i++)
+	{
+		uint8_t record[PROFILE_RECORD_SIZE];
+		profile_encode(&profiles[i], record);
+
+		int pos	 = i * PROFILE_RECORD_SIZE - start; // record position in the sector, negative if it starts before
+		int from = MAX(0, -pos);
+		int to	 = MIN(PROFILE_RECORD_SIZE, FLASH_SECTOR_SIZE - pos);
+		memcpy(sector_buffer + pos + from, record + from, to - from);
+	}
+}
+
+/**
+ * @brief Replaces the whole library.
+ *
+ * Records and index are written first and the header last. The header goes to the older copy, so
+ * until it is written the newer copy still describes the previous library.
+ *
+ * @param profiles The profiles to store.
+ * @param count    Number of profiles, 1 - STORAGE_MAX_PROFILES.
+ * @param current  Index of the profile in use.
+ * @return true if every write verified.
+ */
+bool storage_format(const profile_t* profiles, int count, int current)
+{
+	storage_cancel_deferred(-1);
+	bool ok = true;
+	for(int sector = 0; sector * FLASH_SECTOR_SIZE < count * PROFILE_RECORD_SIZE; sector++)
+	{
+		storage_fill_records(sector, profiles, count);
+		ok &= storage_update_sector(STORAGE_RECORD_OFFSET + sector * FLASH_SECTOR_SIZE);
+	}
+
+	const int per_sector = FLASH_SECTOR_SIZE / sizeof(storage_entry_t);
+	for(int sector = 0; sector * per_sector < count; sector++)
+	{
+		storage_entry_t* entries = (storage_entry_t*) sector_buffer;
+		memset(sector_buffer, 0xFF, sizeof(sector_buffer));
+		for(int i = 0; i < per_sector && sector * per_sector + i < count; i++)
+		{
+			uint8_t record[PROFILE_RECORD_SIZE];
+			int		index = sector * per_sector + i;
+			profile_encode(&profiles[index], record);
+			storage_fill_entry(&entries[i], index, &profiles[index], record);
+		}
+		ok &= storage_update_sector(STORAGE_INDEX_OFFSET + sector * FLASH_SECTOR_SIZE);
+	}
+
+	header.magic   = STORAGE_MAGIC;
+	header.count   = count;
+	header.current = current >= 0 && current < count ? current : 0;
+	return storage_write_header() && ok;
+}
+
+/**
+ * @brief Returns the number of profiles in the library.
+ */
+int storage_count()
+{
+	return header.count;
+}
+
+/**
+ * @brief Returns the index of the profile in use, as last stored.
+ */
+int storage_current()
+{
+	return header.current;
+}
+
+/**
+ * @brief Stores the index of the profile in use. Nothing is written if it did not change.
+ *
+ * @return false if the header write did not verify.
+ */
+bool storage_set_current(int index)
+{
+	if(index < 0 || index >= header.count || index == header.current)
+	{
+		return true;
+	}
+	header.current = index;
+	return storage_write_header();
+}
+
+/**
+ * @brief Returns the name of a profile, pointing into the flash index. No copy is made.
+ */
+const char* storage_name(int index)
+{
+	return storage_entry(index)->name;
+}
+
+/**
+ * @brief Decodes a profile straight from flash, for browsing. The CRC is not checked.
+ *
+ * @param index   Profile index.
+ * @param profile Receives the profile, sanitized.
+ * @return false if the record version is unknown.
+ */
+bool storage_peek(int index, profile_t* profile)
+{
+	return profile_decode(storage_record(index), profile);
+}
+
+/**
+ * @brief Copies a profile into RAM for editing and checks it against the CRC of its index entry.
+ *
+ * @param index   Profile index.
+ * @param profile Receives the profile, sanitized.
+ * @return true if the CRC matched and the record decoded, false if the record is damaged (the copy is
+ * still made).
+ */
+bool storage_load(int index, profile_t* profile)
+{
+	const uint8_t* record = storage_record(index);
+	bool		   valid  = crc32(record, PROFILE_RECORD_SIZE) == storage_entry(index)->crc;
+	return profile_decode(record, profile) && valid;
+}
+
+/**
+ * @brief Writes an edited profile back to the library.
+ *
+ * Only this profile's record and index entry are rewritten, and nothing at all if the record in
+ * flash is already identical.
+ *
+ * @param index   Profile index.
+ * @param profile The edited profile.
+ * @return false if the write did not verify, true if it did or nothing had to be written.
+ */
+bool storage_save(int index, const profile_t* profile)
+{
+	uint8_t record[PROFILE_RECORD_SIZE];
+	profile_encode(profile, record);
+	storage_cancel_deferred(index);
+	if(storage_is_saved(index, record))
+	{
+		return true;
+	}
+	return storage_write_record(index, record) && storage_write_entry(index, profile, record);
+}
+
+/**
+ * @brief Task that writes a deferred save: the record, then the index entry, one flash operation per step.
+ *
+ * A sector erase and each program of a sector's pages get a step of their own, so the main loop handles
+ * input and refreshes the outputs between them instead of waiting for a whole save, and interrupts are
+ * only ever off for a single flash operation. Flash reads in between finish the sector being written
+ * first, see `storage_settle()`. A save of the same profile handed over while the record is written
+ * starts over with the newer profile, so the entry is never written with the CRC of an outdated record.
+ * Once the record is being written its entry always follows, from here or from `storage_drop_deferred()`,
+ * unless a synchronous write of the same profile replaced both.
+ */
+static task_status_t storage_deferred_task_fn(task_t* task)
+{
+	static int			   index; // profile being written, `deferred_index` may change between the steps
+	static storage_entry_t entry; // entry being written
+
+	TASK_BEGIN(task);
+	while(deferred_index >= 0)
+	{
+		deferred_restart = false;
+		index			 = deferred_index;
+		entry_profile	 = deferred_profile;
+		profile_encode(&entry_profile, entry_record);
+		if(storage_is_saved(index, entry_record))
+		{
+			deferred_index = -1;
+			entry_index	   = -1;
+			continue;
+		}
+		entry_index = index;
+		storage_writer_start(&deferred_writer, storage_record_offset(index), entry_record, PROFILE_RECORD_SIZE);
+		while(storage_writer_step(&deferred_writer))
+		{
+			TASK_YIELD(task);
+		}
+		if(entry_index < 0 || (deferred_restart && deferred_index == index))
+		{
+			continue; // entry already written, or superseded by a newer save that rewrites the record
+		}
+		memset(&entry, 0xFF, sizeof(entry));
+		storage_fill_entry(&entry, index, &entry_profile, entry_record);
+		storage_writer_start(&deferred_writer, STORAGE_INDEX_OFFSET + index * sizeof(entry), &entry, sizeof(entry));
+		while(storage_writer_step(&deferred_writer))
+		{
+			TASK_YIELD(task);
+		}
+		entry_index = -1;
+		if(!deferred_restart && deferred_index == index)
+		{
+			deferred_index = -1;
+		}
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Writes an edited profile back to the library in the background.
+ *
+ * The profile is copied and written by a task, one flash operation per step, see `storage_deferred_task_fn()`.
+ * Saves handed over before the previous one finished are coalesced, only the latest profile is written.
+ * A later `storage_save()` of the same profile or `storage_format()` drops the pending save.
+ * Write errors are not reported, the next load finds a damaged record by its CRC; `storage_flush_deferred()`
+ * writes the pending save at once and reports them.
+ *
+ * @param index   Profile index.
+ * @param profile The edited profile.
+ */
+void storage_save_deferred(int index, const profile_t* profile)
+{
+	if(index < 0 || index >= header.count)
+	{
+		return;
+	}
+	deferred_profile = *profile;
+	deferred_index	 = index;
+	deferred_restart = true;
+	if(!task_is_running(&deferred_task))
+	{
+		task_start(&deferred_task, storage_deferred_task_fn);
+	}
+}
+
+/**
+ * @brief Drops a deferred save that has not been written yet, before the library is reloaded.
+ *
+ * A save whose record is being or has been written gets its index entry right away, so the record is never
+ * left with the CRC of its previous contents.
+ */
+void storage_drop_deferred()
+{
+	deferred_index = -1;
+	if(entry_index >= 0)
+	{
+		while(storage_writer_step(&deferred_writer))
+		{
+			// finish the record or entry being written
+		}
+		storage_write_entry(entry_index, &entry_profile, entry_record);
+		entry_index = -1;
+	}
+}
+
+/**
+ * @brief Writes a pending deferred save right away and returns once it is committed.
+ *
+ * A record or entry the task is writing is finished first, then the latest profile handed to
+ * `storage_save_deferred()` is saved with `storage_save()`.
+ *
+ * @return false if the write did not verify, true if it did or no save was pending.
+ */
+bool storage_flush_deferred()
+{
+	if(deferred_index < 0)
+	{
+		storage_drop_deferred();
+		return true;
+	}
+	int		  index	  = deferred_index;
+	profile_t profile = deferred_profile;
+	storage_drop_deferred();
+	return storage_save(index, &profile);
+}
+
+/**
+ * @brief Checks whether a deferred save has not been written completely yet.
+ */
+bool storage_save_pending()
+{
+	return deferred_index >= 0;
+}
+
+/**
+ * @brief Appends a profile to the library.
+ *
+ * @param profile The profile to add.
+ * @return The index of the new profile, or -1 if the library is full or a write did not verify.
+ */
+int storage_add(const profile_t* profile)
+{
+	if(header.count >= STORAGE_MAX_PROFILES)
+	{
+		return -1;
+	}
+	int index = header.count;
+	if(!storage_write_profile(index, profile))
+	{
+		return -1; // the header still excludes the damaged slot
+	}
+	header.count++;
+	if(!storage_write_header()) // the new profile becomes visible with the header
+	{
+		header.count--;
+		return -1;
+	}
+	return index;
+}
+
+/**
+ * @brief Returns the number of sectors erased since boot.
+ */
+uint32_t storage_erase_count()
+{
+	return erase_count;
+}
+
+/**
+ * @brief Returns the number of bytes programmed since boot.
+ */
+uint32_t storage_program_bytes()
+{
+	return program_bytes;
+}
+
+/**
+ * @brief Returns the number of sector writes skipped since boot because flash already held the data.
+ */
+uint32_t storage_skipped_sectors()
+{
+	return skipped_sectors;
+}
+
+/**
+ * @brief Returns the highest number of erases of a single library sector since boot.
+ *
+ * Flash wears per sector, so this is the figure to hold against the rated erase cycles.
+ */
+uint32_t storage_sector_wear()
+{
+	uint32_t wear = 0;
+	for(int i = 0; i < STORAGE_SECTORS; i++)
+	{
+		wear = MAX(wear, sector_erases[i]);
+	}
+	return wear;
+}
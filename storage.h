@@ -0,0 +1,80 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "profile.h"
+
+#define STORAGE_MAX_PROFILES   256		  // profiles the library can hold
+#define STORAGE_MAGIC		   0x4C505247 // "GRPL", marks a formatted library header
+#define STORAGE_VERSION		   1		  // library layout version
+#define STORAGE_HEADER_COPIES  2		  // header sectors, written in turn so one always survives a power cut
+#define STORAGE_INDEX_SECTORS  2		  // sectors holding the index, STORAGE_MAX_PROFILES entries
+#define STORAGE_RECORD_SECTORS 3		  // sectors holding the profile records, STORAGE_MAX_PROFILES records
+#define STORAGE_SECTORS		   (STORAGE_HEADER_COPIES + STORAGE_INDEX_SECTORS + STORAGE_RECORD_SECTORS)
+
+/**
+ * @brief Flash offsets of the library. It sits right below the last sector, which keeps the
+ * single-record save format of earlier firmware so it can still be imported.
+ *
+ * Header copy n is at `STORAGE_HEADER_OFFSET - n * FLASH_SECTOR_SIZE`, copy 1 is the lowest sector of
+ * the library.
+ */
+#define STORAGE_LEGACY_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define STORAGE_BASE_OFFSET	  (STORAGE_LEGACY_OFFSET - STORAGE_SECTORS * FLASH_SECTOR_SIZE)
+#define STORAGE_HEADER_OFFSET (STORAGE_BASE_OFFSET + (STORAGE_HEADER_COPIES - 1) * FLASH_SECTOR_SIZE)
+#define STORAGE_INDEX_OFFSET  (STORAGE_HEADER_OFFSET + FLASH_SECTOR_SIZE)
+#define STORAGE_RECORD_OFFSET (STORAGE_INDEX_OFFSET + STORAGE_INDEX_SECTORS * FLASH_SECTOR_SIZE)
+
+#define STORAGE_LEGACY_PROFILES 5 // profiles a legacy save holds, see storage_read_legacy()
+
+/**
+ * @struct storage_header_t
+ * @brief First bytes of a header sector. Written last when the library changes size. Every write goes
+ * to the older of the `STORAGE_HEADER_COPIES` copies, so a write cut short leaves the newer one intact.
+ */
+typedef struct
+{
+	uint32_t magic;	   // STORAGE_MAGIC
+	uint16_t version;  // STORAGE_VERSION
+	uint16_t count;	   // profiles in the library
+	uint16_t current;  // profile in use
+	uint16_t sequence; // incremented by every write, the valid copy with the newer one is current
+	uint32_t crc;	   // CRC-32 of the fields above
+} storage_header_t;
+
+/**
+ * @struct storage_entry_t
+ * @brief Index entry of one profile, 32 bytes. The names of all profiles sit next to each other in the
+ * index, so browsing reads them straight from XIP flash without touching the records. Everything in an
+ * entry can be derived from its record, so entries lost to a cut index write are rebuilt at boot.
+ */
+typedef struct
+{
+	char	 name[PROFILE_NAME_LEN]; // copy of the profile name
+	uint32_t offset;				 // flash offset of the record, always `STORAGE_RECORD_OFFSET` + index * size
+	uint32_t crc;					 // CRC-32 of the record
+	uint8_t	 reserved[12];			 // erased (0xFF), pads the entry to 32 bytes so entries never straddle a page
+} storage_entry_t;
+
+extern bool				storage_init();
+extern int				storage_read_legacy(profile_t* profiles, int* current);
+extern bool				storage_format(const profile_t* profiles, int count, int current);
+extern int				storage_count();
+extern int				storage_current();
+extern bool				storage_set_current(int index);
+extern const char*		storage_name(int index);
+extern bool				storage_peek(int index, profile_t* profile);
+extern bool				storage_load(int index, profile_t* profile);
+extern bool				storage_save(int index, const profile_t* profile);
+extern void				storage_save_deferred(int index, const profile_t* profile);
+extern bool				storage_save_pending();
+extern void				storage_drop_deferred();
+extern bool				storage_flush_deferred();
+extern int				storage_add(const profile_t* profile);
+extern uint32_t			storage_erase_count();
+extern uint32_t			storage_program_bytes();
+extern uint32_t			storage_skipped_sectors();
+extern uint32_t			storage_sector_wear();
+
+#endif // STORAGE_H
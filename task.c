@@ -0,0 +1,188 @@
+#include <assert.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "task.h"
+
+static task_t*			 tasks[TASK_MAX];	 // registered tasks, NULL for free slots
+static volatile uint32_t pending_events = 0; // events signalled since the last scheduler pass
+static uint32_t			 max_latency_us = 0; // worst delay between a task becoming ready and running
+static uint32_t			 max_run_us		= 0; // worst time spent in a single task step
+
+/**
+ * @brief Starts (or restarts) a task.
+ *
+ * The task is registered with the scheduler and runs from the beginning of `fn` on the next
+ * `task_run()`. Restarting a running task discards its resume point.
+ *
+ * @param task The task state, owned by the caller and kept alive while the task runs.
+ * @param fn   The task body.
+ * @return false if the task table is full (see `TASK_MAX`). The task is then left not running,
+ *         so `task_is_running()` stays false and a later start can try again.
+ */
+bool task_start(task_t* task, task_fn_t fn)
+{
+	int slot = -1;
+	for(int i = 0; i < TASK_MAX; i++)
+	{
+		if(tasks[i] == task)
+		{
+			slot = i; // already registered, restart in place
+			break;
+		}
+		if(tasks[i] == NULL && slot < 0)
+		{
+			slot = i;
+		}
+	}
+	assert(slot >= 0); // TASK_MAX too small for the tasks in use
+	if(slot < 0)
+	{
+		return false;
+	}
+
+	task->fn		  = fn;
+	task->line		  = 0;
+	task->wake_time	  = nil_time;
+	task->wait_events = 0;
+	task->events	  = 0;
+	tasks[slot]		  = task;
+	return true;
+}
+
+/**
+ * @brief Stops a task before it finishes. Nothing happens if it is not running.
+ *
+ * @param task The task state.
+ */
+void task_stop(task_t* task)
+{
+	for(int i = 0; i < TASK_MAX; i++)
+	{
+		if(tasks[i] == task)
+		{
+			tasks[i] = NULL;
+		}
+	}
+	task->fn = NULL;
+}
+
+/**
+ * @brief Checks whether the task has been started and not finished yet.
+ */
+bool task_is_running(const task_t* task)
+{
+	return task->fn != NULL;
+}
+
+/**
+ * @brief Signals events to the tasks waiting in TASK_WAIT_EVENT.
+ *
+ * Safe to call from IRQ context.
+ *
+ * @param events Event bits to signal.
+ */
+void task_signal(uint32_t events)
+{
+	uint32_t ints = save_and_disable_interrupts();
+	pending_events |= events;
+	restore_interrupts(ints);
+}
+
+/**
+ * @brief Runs one step of every task that is ready.
+ *
+ * A task is ready when its wake time has been reached or one of the events it waits for has been
+ * signalled. Called from the main loop; each step runs until the task yields, so the cost of a switch
+ * is one function call plus a jump table lookup. The worst-case wake-up latency and step duration are
+ * recorded for diagnostics.
+ */
+void task_run()
+{
+	uint32_t ints	= save_and_disable_interrupts();
+	uint32_t events = pending_events;
+	pending_events	= 0;
+	restore_interrupts(ints);
+
+	for(int i = 0; i < TASK_MAX; i++)
+	{
+		task_t* task = tasks[i];
+		if(task == NULL)
+		{
+			continue;
+		}
+
+		absolute_time_t now		  = get_absolute_time();
+		bool			has_event = (task->wait_events & events) != 0;
+		if(!has_event && absolute_time_diff_us(task->wake_time, now) < 0)
+		{
+			continue; // not ready yet
+		}
+
+		if(!has_event && !is_nil_time(task->wake_time))
+		{
+			uint32_t latency = (uint32_t) absolute_time_diff_us(task->wake_time, now);
+			if(latency > max_latency_us)
+			{
+				max_latency_us = latency;
+			}
+		}
+
+		task->events		 = task->wait_events & events;
+		task_status_t status = task->fn(task);
+
+		uint32_t run_us		 = (uint32_t) absolute_time_diff_us(now, get_absolute_time());
+		if(run_us > max_run_us)
+		{
+			max_run_us = run_us;
+		}
+
+		if(status == TASK_DONE)
+		{
+			task->fn = NULL;
+			tasks[i] = NULL;
+		}
+	}
+}
+
+/**
+ * @brief Returns the earliest time a waiting task has to be resumed.
+ *
+ * Used to bound the idle sleep. Tasks waiting only for events do not limit it, since the code
+ * that signals them from IRQ context also wakes the core. Events signalled by a task during
+ * `task_run()` are still pending here and make the next pass due immediately.
+ *
+ * @return The earliest wake time, or `at_the_end_of_time` if no task is waiting for a time.
+ */
+absolute_time_t task_next_wake_time()
+{
+	if(pending_events != 0)
+	{
+		return get_absolute_time(); // signalled from a task, deliver before sleeping
+	}
+
+	absolute_time_t next = at_the_end_of_time;
+	for(int i = 0; i < TASK_MAX; i++)
+	{
+		if(tasks[i] != NULL && absolute_time_diff_us(tasks[i]->wake_time, next) > 0)
+		{
+			next = tasks[i]->wake_time;
+		}
+	}
+	return next;
+}
+
+/**
+ * @brief Returns the worst observed delay between a task's wake time and it running, in microseconds.
+ */
+uint32_t task_max_latency_us()
+{
+	return max_latency_us;
+}
+
+/**
+ * @brief Returns the longest observed single task step, in microseconds.
+ */
+uint32_t task_max_run_us()
+{
+	return max_run_us;
+}
@@ -0,0 +1,144 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include "pico/stdlib.h"
+
+/**
+ * @brief Maximum number of tasks registered with the scheduler at the same time. `task_start()` fails
+ * when the table is full, so raise this when adding a task. Tasks in use (11):
+ * - app.c:          message_task, reboot_task, autosave_task
+ * - journal.c:      flush_task, print_task
+ * - light.c:        light_task
+ * - pump_monitor.c: pump_monitor_task, pump_current_task (with PUMP_CURRENT_SENSE)
+ * - sensors.c:      sensors_task
+ * - storage.c:      deferred_task
+ * - thermal.c:      thermal_task
+ */
+#define TASK_MAX 12
+
+/**
+ * @enum task_status_t
+ * @brief Result of running a task body once.
+ *
+ * - TASK_WAITING: The task yielded and wants to be resumed later.
+ * - TASK_DONE:    The task finished and is removed from the scheduler.
+ */
+typedef enum
+{
+	TASK_WAITING,
+	TASK_DONE
+} task_status_t;
+
+typedef struct task task_t;
+
+/**
+ * @brief Task body. Written as a stackless coroutine with the TASK_* macros below.
+ */
+typedef task_status_t (*task_fn_t)(task_t* task);
+
+/**
+ * @struct task
+ * @brief State of one cooperative task.
+ *
+ * Tasks are stackless: local variables do not survive a yield, so any state that must persist
+ * across waits lives in static variables of the owning module.
+ *
+ * @var task::fn
+ *   Task body, NULL while the task is not running.
+ * @var task::line
+ *   Resume point inside the task body (0 = start).
+ * @var task::wake_time
+ *   The task is not resumed before this time.
+ * @var task::wait_events
+ *   Event bits that resume the task before `wake_time`, 0 if it only waits for time.
+ * @var task::events
+ *   Event bits that resumed the task, valid right after a TASK_WAIT_EVENT.
+ */
+struct task
+{
+	task_fn_t		fn;
+	int				line;
+	absolute_time_t wake_time;
+	uint32_t		wait_events;
+	uint32_t		events;
+};
+
+/**
+ * @brief Starts the task body. Must be the first statement of a task function.
+ */
+#define TASK_BEGIN(t) \
+	switch((t)->line) \
+	{                 \
+	case 0:
+
+/**
+ * @brief Ends the task body. Must be the last statement of a task function.
+ */
+#define TASK_END(t) \
+	}               \
+	(t)->line = 0;  \
+	return TASK_DONE
+
+/**
+ * @brief Gives the other tasks and the main loop a chance to run.
+ */
+#define TASK_YIELD(t)                  \
+	do                                 \
+	{                                  \
+		(t)->wake_time	 = nil_time;   \
+		(t)->wait_events = 0;          \
+		(t)->line		 = __LINE__;   \
+		return TASK_WAITING;           \
+	case __LINE__:;                    \
+	} while(0)
+
+/**
+ * @brief Suspends the task for the given number of milliseconds.
+ */
+#define TASK_SLEEP_MS(t, ms)                          \
+	do                                                \
+	{                                                 \
+		(t)->wake_time	 = make_timeout_time_ms(ms);  \
+		(t)->wait_events = 0;                         \
+		(t)->line		 = __LINE__;                  \
+		return TASK_WAITING;                          \
+	case __LINE__:;                                   \
+	} while(0)
+
+/**
+ * @brief Suspends the task until one of the given events is signalled with `task_signal()`.
+ */
+#define TASK_WAIT_EVENT(t, mask)                   \
+	do                                             \
+	{                                              \
+		(t)->wake_time	 = at_the_end_of_time;     \
+		(t)->wait_events = (mask);                 \
+		(t)->line		 = __LINE__;               \
+		return TASK_WAITING;                       \
+	case __LINE__:;                                \
+	} while(0)
+
+/**
+ * @brief Suspends the task until one of the given events is signalled or the given time is reached,
+ * whichever comes first.
+ */
+#define TASK_WAIT_EVENT_UNTIL(t, mask, time)   \
+	do                                         \
+	{                                          \
+		(t)->wake_time	 = (time);             \
+		(t)->wait_events = (mask);             \
+		(t)->line		 = __LINE__;           \
+		return TASK_WAITING;                   \
+	case __LINE__:;                            \
+	} while(0)
+
+extern bool			   task_start(task_t* task, task_fn_t fn);
+extern void			   task_stop(task_t* task);
+extern bool			   task_is_running(const task_t* task);
+extern void			   task_signal(uint32_t events);
+extern void			   task_run();
+extern absolute_time_t task_next_wake_time();
+extern uint32_t		   task_max_latency_us();
+extern uint32_t		   task_max_run_us();
+
+#endif // TASK_H
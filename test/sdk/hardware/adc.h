@@ -0,0 +1,57 @@
+#ifndef HARDWARE_ADC_H
+#define HARDWARE_ADC_H
+
+#include "pico/stdlib.h"
+
+#define ADC_CS_READY_BITS 0x00000100
+#define ADC_FCS_OVER_BITS 0x00000800
+#define DREQ_ADC		  36
+
+typedef struct
+{
+	volatile uint32_t cs;
+	volatile uint32_t result;
+	volatile uint32_t fcs;
+	volatile uint32_t fifo;
+} adc_hw_t;
+
+extern adc_hw_t* const adc_hw;
+
+static inline void adc_init()
+{
+}
+
+static inline void adc_gpio_init(uint gpio)
+{
+}
+
+static inline void adc_set_temp_sensor_enabled(bool enable)
+{
+}
+
+static inline void adc_select_input(uint input)
+{
+}
+
+static inline void adc_set_round_robin(uint input_mask)
+{
+}
+
+static inline void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift)
+{
+}
+
+static inline void adc_set_clkdiv(float clkdiv)
+{
+}
+
+static inline void adc_run(bool run)
+{
+}
+
+static inline uint8_t adc_fifo_get_level()
+{
+	return 0;
+}
+
+#endif // HARDWARE_ADC_H
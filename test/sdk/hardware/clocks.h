@@ -0,0 +1,19 @@
+#ifndef HARDWARE_CLOCKS_H
+#define HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+enum clock_index
+{
+	clk_sys = 5,
+	clk_adc = 8,
+};
+
+extern uint32_t host_sys_hz;
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index)
+{
+	return clk_index == clk_adc ? 48000000 : host_sys_hz;
+}
+
+#endif // HARDWARE_CLOCKS_H
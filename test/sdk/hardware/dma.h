@@ -0,0 +1,107 @@
+#ifndef HARDWARE_DMA_H
+#define HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+enum dma_channel_transfer_size
+{
+	DMA_SIZE_8	= 0,
+	DMA_SIZE_16 = 1,
+	DMA_SIZE_32 = 2,
+};
+
+typedef struct
+{
+	volatile uint32_t read_addr;
+	volatile uint32_t write_addr;
+	volatile uint32_t transfer_count;
+	volatile uint32_t ctrl_trig;
+	volatile uint32_t al1_ctrl;
+	volatile uint32_t al1_read_addr;
+	volatile uint32_t al1_write_addr;
+	volatile uint32_t al1_transfer_count_trig;
+	volatile uint32_t al2_ctrl;
+	volatile uint32_t al2_transfer_count;
+	volatile uint32_t al2_read_addr;
+	volatile uint32_t al2_write_addr_trig;
+	volatile uint32_t al3_ctrl;
+	volatile uint32_t al3_write_addr;
+	volatile uint32_t al3_transfer_count;
+	volatile uint32_t al3_read_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct
+{
+	dma_channel_hw_t  ch[12];
+	volatile uint32_t intr;
+} dma_hw_t;
+
+typedef struct
+{
+	uint32_t ctrl;
+} dma_channel_config;
+
+extern dma_hw_t* const dma_hw;
+
+static inline int dma_claim_unused_channel(bool required)
+{
+	return 0;
+}
+
+static inline dma_channel_config dma_channel_get_default_config(uint channel)
+{
+	return (dma_channel_config) {0};
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size)
+{
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config* c, bool incr)
+{
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config* c, bool incr)
+{
+}
+
+static inline void channel_config_set_dreq(dma_channel_config* c, uint dreq)
+{
+}
+
+static inline void channel_config_set_ring(dma_channel_config* c, bool write, uint size_bits)
+{
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config* c, uint chain_to)
+{
+}
+
+static inline void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr,
+										 const volatile void* read_addr, uint transfer_count, bool trigger)
+{
+}
+
+static inline void dma_channel_start(uint channel)
+{
+}
+
+static inline void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+}
+
+static inline bool dma_channel_get_irq0_status(uint channel)
+{
+	return false;
+}
+
+static inline void dma_channel_acknowledge_irq0(uint channel)
+{
+}
+
+static inline dma_channel_hw_t* dma_channel_hw_addr(uint channel)
+{
+	return &dma_hw->ch[channel];
+}
+
+#endif // HARDWARE_DMA_H
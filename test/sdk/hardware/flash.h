@@ -0,0 +1,12 @@
+#ifndef HARDWARE_FLASH_H
+#define HARDWARE_FLASH_H
+
+#include "pico/stdlib.h"
+
+#define FLASH_PAGE_SIZE	  (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+
+extern void flash_range_erase(uint32_t flash_offs, size_t count);
+extern void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count);
+
+#endif // HARDWARE_FLASH_H
@@ -0,0 +1,34 @@
+#ifndef HARDWARE_GPIO_H
+#define HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+#define GPIO_OUT 1
+
+enum gpio_function
+{
+	GPIO_FUNC_I2C = 3,
+	GPIO_FUNC_PWM = 4,
+};
+
+static inline void gpio_init(uint gpio)
+{
+}
+
+static inline void gpio_set_dir(uint gpio, bool out)
+{
+}
+
+static inline void gpio_put(uint gpio, bool value)
+{
+}
+
+static inline void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+}
+
+static inline void gpio_pull_up(uint gpio)
+{
+}
+
+#endif // HARDWARE_GPIO_H
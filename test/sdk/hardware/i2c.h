@@ -0,0 +1,20 @@
+#ifndef HARDWARE_I2C_H
+#define HARDWARE_I2C_H
+
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+
+#define i2c1 ((i2c_inst_t*) NULL)
+
+static inline uint i2c_init(i2c_inst_t* i2c, uint baudrate)
+{
+	return baudrate;
+}
+
+static inline uint i2c_set_baudrate(i2c_inst_t* i2c, uint baudrate)
+{
+	return baudrate;
+}
+
+#endif // HARDWARE_I2C_H
@@ -0,0 +1,19 @@
+#ifndef HARDWARE_IRQ_H
+#define HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define PWM_IRQ_WRAP 4
+#define DMA_IRQ_0	 11
+
+typedef void (*irq_handler_t)();
+
+static inline void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+}
+
+static inline void irq_set_enabled(uint num, bool enabled)
+{
+}
+
+#endif // HARDWARE_IRQ_H
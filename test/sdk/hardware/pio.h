@@ -0,0 +1,26 @@
+#ifndef HARDWARE_PIO_H
+#define HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+typedef struct pio_instance* PIO;
+
+typedef struct pio_program
+{
+	const uint16_t* instructions;
+	uint8_t			length;
+	int8_t			origin;
+} pio_program_t;
+
+#define pio0 ((PIO) NULL)
+
+static inline uint pio_add_program(PIO pio, const pio_program_t* program)
+{
+	return 0;
+}
+
+static inline void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm, uint16_t div_int, uint8_t div_frac)
+{
+}
+
+#endif // HARDWARE_PIO_H
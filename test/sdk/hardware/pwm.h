@@ -0,0 +1,78 @@
+#ifndef HARDWARE_PWM_H
+#define HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+#define NUM_PWM_SLICES 8
+
+enum pwm_chan
+{
+	PWM_CHAN_A = 0,
+	PWM_CHAN_B = 1,
+};
+
+typedef struct
+{
+	volatile uint32_t csr;
+	volatile uint32_t div;
+	volatile uint32_t ctr;
+	volatile uint32_t cc;
+	volatile uint32_t top;
+} pwm_slice_hw_t;
+
+typedef struct
+{
+	pwm_slice_hw_t	  slice[NUM_PWM_SLICES];
+	volatile uint32_t en;
+} pwm_hw_t;
+
+extern pwm_hw_t* const pwm_hw;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio)
+{
+	return (gpio >> 1) & 7;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio)
+{
+	return gpio & 1;
+}
+
+static inline uint pwm_get_dreq(uint slice_num)
+{
+	return 24 + slice_num;
+}
+
+static inline void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract)
+{
+	pwm_hw->slice[slice_num].div = (uint32_t) integer << 4 | fract;
+}
+
+static inline void pwm_set_wrap(uint slice_num, uint16_t wrap)
+{
+	pwm_hw->slice[slice_num].top = wrap;
+}
+
+static inline void pwm_set_output_polarity(uint slice_num, bool a, bool b)
+{
+}
+
+static inline void pwm_set_mask_enabled(uint32_t mask)
+{
+	pwm_hw->en = mask;
+}
+
+static inline void pwm_set_irq_enabled(uint slice_num, bool enabled)
+{
+}
+
+static inline void pwm_clear_irq(uint slice_num)
+{
+}
+
+static inline uint32_t pwm_get_irq_status_mask()
+{
+	return 0;
+}
+
+#endif // HARDWARE_PWM_H
@@ -0,0 +1,15 @@
+#ifndef HARDWARE_SYNC_H
+#define HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+static inline uint32_t save_and_disable_interrupts()
+{
+	return 0;
+}
+
+static inline void restore_interrupts(uint32_t status)
+{
+}
+
+#endif // HARDWARE_SYNC_H
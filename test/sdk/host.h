@@ -0,0 +1,14 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include "pico/stdlib.h"
+
+extern uint64_t host_time_us;		   // what `get_absolute_time()` returns, advanced by the tests
+extern uint32_t host_sys_hz;		   // what `clock_get_hz(clk_sys)` returns
+extern uint32_t host_flash_erases;	   // sectors erased since `host_flash_reset()`
+extern uint32_t host_flash_programmed; // bytes programmed since `host_flash_reset()`
+
+extern void host_flash_reset();
+extern void host_advance_us(uint64_t us);
+
+#endif // HOST_H
@@ -0,0 +1,84 @@
+#ifndef PICO_STDLIB_H
+#define PICO_STDLIB_H
+
+// Host stand-in for the parts of the Pico SDK the tested sources use. Time is a counter the tests advance,
+// flash is a RAM array, see `host.h`.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PICO_ON_DEVICE		  0
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#define XIP_BASE			  ((uintptr_t) host_flash)
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define MIN(a, b)	((a) < (b) ? (a) : (b))
+#define MAX(a, b)	((a) > (b) ? (a) : (b))
+
+#define nil_time		   ((absolute_time_t) 0)
+#define at_the_end_of_time ((absolute_time_t) INT64_MAX)
+
+typedef unsigned int uint;
+typedef uint64_t	 absolute_time_t;
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t* rt);
+
+/**
+ * @brief A repeating timer, fired by `host_advance_us()` when time passes its next alarm.
+ */
+struct repeating_timer
+{
+	int64_t					   delay_us;
+	absolute_time_t			   alarm;
+	repeating_timer_callback_t callback;
+	void*					   user_data;
+	repeating_timer_t*		   next;
+};
+
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+extern absolute_time_t get_absolute_time();
+extern int64_t		   absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+extern absolute_time_t make_timeout_time_ms(uint32_t ms);
+extern bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void* user_data,
+								   repeating_timer_t* out);
+
+static inline uint32_t time_us_32()
+{
+	return (uint32_t) get_absolute_time();
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t)
+{
+	return t;
+}
+
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us)
+{
+	return t + us;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t)
+{
+	return (uint32_t) (t / 1000);
+}
+
+static inline bool is_nil_time(absolute_time_t t)
+{
+	return t == nil_time;
+}
+
+static inline void tight_loop_contents()
+{
+}
+
+static inline void hw_set_bits(volatile uint32_t* addr, uint32_t mask)
+{
+	*addr |= mask;
+}
+
+#endif // PICO_STDLIB_H
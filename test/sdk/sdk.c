@@ -0,0 +1,138 @@
+#include <assert.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/pwm.h"
+#include "host.h"
+
+uint8_t	 host_flash[PICO_FLASH_SIZE_BYTES];
+uint64_t host_time_us		   = 1000000; // not at nil_time, which means "never" to some callers
+uint32_t host_sys_hz		   = 125000000;
+uint32_t host_flash_erases	   = 0;
+uint32_t host_flash_programmed = 0;
+
+static adc_hw_t host_adc;
+static dma_hw_t host_dma;
+static pwm_hw_t host_pwm;
+
+static repeating_timer_t* host_timers = NULL; // timers added with `add_repeating_timer_us()`
+
+adc_hw_t* const adc_hw = &host_adc;
+dma_hw_t* const dma_hw = &host_dma;
+pwm_hw_t* const pwm_hw = &host_pwm;
+
+/**
+ * @brief Erases the whole flash and clears the counters.
+ */
+void host_flash_reset()
+{
+	memset(host_flash, 0xFF, sizeof(host_flash));
+	host_flash_erases	  = 0;
+	host_flash_programmed = 0;
+}
+
+/**
+ * @brief Returns `host_time_us`, time only moves when a test advances it.
+ */
+absolute_time_t get_absolute_time()
+{
+	return host_time_us;
+}
+
+/**
+ * @brief Returns the microseconds from `from` to `to`.
+ */
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to)
+{
+	return (int64_t) (to - from);
+}
+
+/**
+ * @brief Returns the time `ms` milliseconds from now.
+ */
+absolute_time_t make_timeout_time_ms(uint32_t ms)
+{
+	return host_time_us + ms * 1000ull;
+}
+
+/**
+ * @brief Adds a timer that `host_advance_us()` fires. Like the SDK, a negative delay repeats at a fixed rate
+ * from the previous alarm, a positive one from the end of the callback.
+ */
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void* user_data,
+							repeating_timer_t* out)
+{
+	out->delay_us  = delay_us;
+	out->alarm	   = host_time_us + (delay_us < 0 ? -delay_us : delay_us);
+	out->callback  = callback;
+	out->user_data = user_data;
+	for(repeating_timer_t* timer = host_timers; timer; timer = timer->next)
+	{
+		if(timer == out)
+		{
+			return true; // re-added by a second init
+		}
+	}
+	out->next	= host_timers;
+	host_timers = out;
+	return true;
+}
+
+/**
+ * @brief Moves time forward by `us`, firing every timer alarm on the way at its own time.
+ */
+void host_advance_us(uint64_t us)
+{
+	absolute_time_t end = host_time_us + us;
+	for(;;)
+	{
+		repeating_timer_t* due = NULL;
+		for(repeating_timer_t* timer = host_timers; timer; timer = timer->next)
+		{
+			if(timer->callback && timer->alarm <= end && (!due || timer->alarm < due->alarm))
+			{
+				due = timer;
+			}
+		}
+		if(!due)
+		{
+			break;
+		}
+		host_time_us = due->alarm;
+		if(!due->callback(due))
+		{
+			due->callback = NULL;
+		} else
+		{
+			due->alarm = due->delay_us < 0 ? due->alarm - due->delay_us : host_time_us + due->delay_us;
+		}
+	}
+	host_time_us = end;
+}
+
+/**
+ * @brief Erases whole sectors like the flash chip does.
+ */
+void flash_range_erase(uint32_t flash_offs, size_t count)
+{
+	assert(flash_offs % FLASH_SECTOR_SIZE == 0 && count % FLASH_SECTOR_SIZE == 0);
+	assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+	memset(host_flash + flash_offs, 0xFF, count);
+	host_flash_erases += count / FLASH_SECTOR_SIZE;
+}
+
+/**
+ * @brief Programs whole pages. Like NOR flash, programming only clears bits.
+ */
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count)
+{
+	assert(flash_offs % FLASH_PAGE_SIZE == 0 && count % FLASH_PAGE_SIZE == 0);
+	assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+	for(size_t i = 0; i < count; i++)
+	{
+		host_flash[flash_offs + i] &= data[i];
+	}
+	host_flash_programmed += count;
+}
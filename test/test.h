@@ -0,0 +1,50 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+/**
+ * @brief Reports a failed check with its location and carries on with the test.
+ */
+#define TEST_CHECK(cond)                                                    \
+	do                                                                      \
+	{                                                                       \
+		if(!(cond))                                                         \
+		{                                                                   \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			test_failures++;                                                \
+		}                                                                   \
+	} while(0)
+
+/**
+ * @brief Checks two integers for equality and prints both on failure.
+ */
+#define TEST_EQUAL(actual, expected)                                                                           \
+	do                                                                                                         \
+	{                                                                                                          \
+		long long a_ = (long long) (actual), e_ = (long long) (expected);                                      \
+		if(a_ != e_)                                                                                           \
+		{                                                                                                      \
+			printf("%s:%d: %s is %lld, expected %s (%lld)\n", __FILE__, __LINE__, #actual, a_, #expected, e_); \
+			test_failures++;                                                                                   \
+		}                                                                                                      \
+	} while(0)
+
+/**
+ * @brief Runs one test function of the executable.
+ */
+#define TEST_RUN(fn)         \
+	do                       \
+	{                        \
+		printf("%s\n", #fn); \
+		fn();                \
+	} while(0)
+
+/**
+ * @brief Ends `main()`, the exit code tells ctest whether every check passed.
+ */
+#define TEST_RESULT() (printf("%d failure(s)\n", test_failures), test_failures != 0)
+
+#endif // TEST_H
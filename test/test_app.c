@@ -0,0 +1,496 @@
+#include <string.h>
+#include <time.h>
+#include "pico/bootrom.h"
+#include "app.h"
+#include "host.h"
+#include "journal.h"
+#include "light.h"
+#include "power.h"
+#include "sensors.h"
+#include "ssd1306.h"
+#include "storage.h"
+#include "task.h"
+#include "test.h"
+#include "thermal.h"
+#include "timebase.h"
+#include "ui_list.h"
+
+#define SCREEN_STRINGS 32 // strings one frame can hold, more than any screen draws
+
+static char drawn[SCREEN_STRINGS][32]; // strings drawn since the last `ssd1306_clear()`
+static int	drawn_count = 0;
+static char shown[SCREEN_STRINGS][32]; // strings of the last frame sent to the panel
+static int	shown_count = 0;
+static int	frames		= 0; // frames sent to the panel
+static bool display_on	= true;
+
+// The OLED records the strings of a frame, so the tests can tell which screen is shown.
+
+bool ssd1306_init(ssd1306_t* p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t* i2c_instance)
+{
+	return true;
+}
+
+void ssd1306_clear(ssd1306_t* p)
+{
+	drawn_count = 0;
+}
+
+void ssd1306_draw_string(ssd1306_t* p, uint32_t x, uint32_t y, uint32_t scale, const char* s)
+{
+	if(drawn_count < SCREEN_STRINGS)
+	{
+		snprintf(drawn[drawn_count++], sizeof(drawn[0]), "%s", s);
+	}
+}
+
+void ssd1306_draw_line(ssd1306_t* p, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+}
+
+void ssd1306_show(ssd1306_t* p)
+{
+	memcpy(shown, drawn, sizeof(shown));
+	shown_count = drawn_count;
+	frames++;
+}
+
+void ssd1306_poweroff(ssd1306_t* p)
+{
+	display_on = false;
+}
+
+void ssd1306_poweron(ssd1306_t* p)
+{
+	display_on = true;
+}
+
+// The other modules app.c talks to report a cool chip in the dark and a healthy ADC.
+
+void light_set_target_percent(int percent)
+{
+}
+
+int32_t light_trim_q8()
+{
+	return LIGHT_TRIM_ONE;
+}
+
+int32_t thermal_celsius10()
+{
+	return 250;
+}
+
+bool thermal_derating()
+{
+	return false;
+}
+
+int32_t thermal_scale_q8()
+{
+	return THERMAL_SCALE_ONE;
+}
+
+uint32_t sensors_overruns()
+{
+	return 0;
+}
+
+void power_add_clock_listener(power_clock_listener_t listener)
+{
+}
+
+void power_boost()
+{
+}
+
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask, uint32_t disable_interface_mask)
+{
+}
+
+/**
+ * @brief Checks whether the last frame shows a string starting with `prefix`.
+ */
+static bool screen_has(const char* prefix)
+{
+	for(int i = 0; i < shown_count; i++)
+	{
+		if(strncmp(shown[i], prefix, strlen(prefix)) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Each screen is recognized by a string only it draws.
+
+static bool on_state_screen()
+{
+	return screen_has("P:");
+}
+
+static bool on_profile_browser()
+{
+	return screen_has("1-T:") && screen_has("2-T:") && strchr(shown[shown_count - 1], '|') != NULL;
+}
+
+static bool on_edit_profile()
+{
+	return screen_has("BACK") && !screen_has("TIME:");
+}
+
+static bool on_edit_period()
+{
+	return screen_has("BACK") && screen_has("TIME:");
+}
+
+static bool on_top_menu()
+{
+	return screen_has("TIME SHIFT");
+}
+
+/**
+ * @brief Name of the profile on the state screen, which is its first string.
+ */
+static const char* state_profile()
+{
+	return shown_count > 0 ? shown[0] : "";
+}
+
+/**
+ * @brief Runs the main loop for `ms` milliseconds in 10 ms passes, like `main()` does between inputs.
+ */
+static void run_ms(uint32_t ms)
+{
+	for(uint32_t t = 0; t < ms; t += 10)
+	{
+		host_advance_us(10000);
+		app_tick();
+		task_run();
+	}
+}
+
+/**
+ * @brief Turns the encoder after a pause, so the lists do not take it for fast scrolling.
+ */
+static void turn(int delta)
+{
+	run_ms(UI_LIST_ACCEL_MS * 2);
+	app_on_encoder_change(delta);
+}
+
+/**
+ * @brief Leaves the UI alone until it times out to the state screen.
+ */
+static void go_idle()
+{
+	run_ms(61000);
+	TEST_CHECK(on_state_screen());
+	TEST_CHECK(!display_on);
+}
+
+/**
+ * @brief Checks the type and argument of the newest journal event.
+ */
+static void check_last_event(journal_event_id_t type, int arg)
+{
+	journal_event_t event;
+	TEST_CHECK(journal_read(0, &event));
+	TEST_EQUAL(event.type, type);
+	TEST_EQUAL(event.arg, arg);
+}
+
+/**
+ * @brief An empty library is formatted with the defaults and the state screen shows the first one.
+ */
+static void test_boot()
+{
+	host_flash_reset();
+	timebase_init();
+	journal_init();
+	app_init();
+	TEST_CHECK(on_state_screen());
+	TEST_EQUAL(strcmp(state_profile(), "VEG"), 0);
+	TEST_EQUAL(storage_count(), 6);
+	TEST_CHECK(display_on);
+}
+
+/**
+ * @brief Turning from the state screen browses the profiles. Scrolling back to the current profile returns
+ * to the state screen, one more detent up opens the top menu, and a detent up from the top menu goes back.
+ */
+static void test_browse()
+{
+	turn(1);
+	TEST_CHECK(on_profile_browser());
+	TEST_CHECK(screen_has("FLOWER"));
+
+	turn(-1);
+	TEST_CHECK(on_state_screen());
+	TEST_EQUAL(strcmp(state_profile(), "VEG"), 0);
+
+	turn(-1);
+	TEST_CHECK(on_top_menu());
+	TEST_EQUAL(strcmp(shown[0], ">"), 0); // the first item is selected
+
+	turn(-1);
+	TEST_CHECK(on_state_screen());
+
+	// a single detent down from the last profile wraps to the first
+	for(int i = 0; i < storage_count() - 1; i++)
+	{
+		turn(1);
+	}
+	TEST_CHECK(on_profile_browser());
+	TEST_CHECK(screen_has("CUSTOM 2"));
+	turn(1);
+	TEST_CHECK(on_state_screen());
+
+	// a fast turn moves by APP_PROFILE_ACCEL profiles and stops at the last one
+	turn(1);
+	app_on_encoder_change(1);
+	TEST_CHECK(on_profile_browser());
+	TEST_CHECK(screen_has("CUSTOM 2"));
+	go_idle();
+}
+
+/**
+ * @brief Clicking a profile in the browser makes it the current one, the press that wakes the display
+ * already turns the browser.
+ */
+static void test_switch_profile()
+{
+	turn(1);
+	TEST_CHECK(display_on);
+	TEST_CHECK(on_profile_browser());
+	turn(1);
+	TEST_CHECK(screen_has("FRUIT"));
+
+	app_on_click();
+	TEST_CHECK(on_state_screen());
+	TEST_EQUAL(strcmp(state_profile(), "FRUIT"), 0);
+	check_last_event(JOURNAL_PROFILE, 2);
+
+	// browsing back to VEG and switching restores the first profile
+	turn(-1);
+	turn(-1);
+	TEST_CHECK(on_profile_browser());
+	app_on_click();
+	TEST_EQUAL(strcmp(state_profile(), "VEG"), 0);
+	check_last_event(JOURNAL_PROFILE, 0);
+	go_idle();
+}
+
+/**
+ * @brief Opens the "Edit Period" screen on the first period from the state screen.
+ */
+static void open_first_period()
+{
+	app_on_click();
+	TEST_CHECK(on_edit_profile());
+	turn(1); // BACK -> period 1
+	app_on_click();
+	TEST_CHECK(on_edit_period());
+}
+
+/**
+ * @brief Editing the duration of a period and leaving through BACK commits it, and the autosave writes it
+ * to flash once the edits pause.
+ */
+static void test_edit_commit()
+{
+	app_on_click(); // wakes the display and opens "Edit Profile"
+	TEST_CHECK(on_edit_profile());
+	turn(-1); // BACK wraps to the last period and back
+	turn(1);
+	app_on_click(); // BACK
+	TEST_CHECK(on_state_screen());
+
+	open_first_period();
+	TEST_CHECK(screen_has("TIME:14"));
+	turn(1);		// BACK -> TIME
+	app_on_click(); // edit the duration
+	turn(2);
+	TEST_CHECK(screen_has("TIME:16"));
+	app_on_click(); // done with the duration
+	turn(-1);
+	app_on_click(); // BACK commits
+	TEST_CHECK(on_edit_profile());
+	TEST_CHECK(screen_has("1-T:16"));
+
+	profile_t stored;
+	period_t  period;
+	TEST_CHECK(storage_peek(0, &stored));
+	profile_get_period(&stored, 0, &period);
+	TEST_EQUAL(period.duration, 14 * 60); // not written yet
+
+	run_ms(15000);
+	TEST_CHECK(!storage_save_pending());
+	TEST_CHECK(storage_peek(0, &stored));
+	profile_get_period(&stored, 0, &period);
+	TEST_EQUAL(period.duration, 16 * 60);
+	check_last_event(JOURNAL_AUTOSAVE, 0);
+	go_idle();
+}
+
+/**
+ * @brief A long press drops the edit session, shows CANCELLED and returns to "Edit Profile" with the
+ * period unchanged. Outside an edit session it only wakes the display.
+ */
+static void test_edit_cancel()
+{
+	app_on_long_press();
+	TEST_CHECK(display_on);
+	TEST_CHECK(on_state_screen());
+
+	open_first_period();
+	TEST_CHECK(screen_has("TIME:16"));
+	turn(1);
+	app_on_click();
+	turn(-3);
+	TEST_CHECK(screen_has("TIME:13"));
+
+	app_on_long_press();
+	TEST_CHECK(screen_has("CANCELLED"));
+	turn(1); // ignored while the message is shown
+	TEST_CHECK(screen_has("CANCELLED"));
+	run_ms(2100);
+	TEST_CHECK(on_edit_profile());
+	TEST_CHECK(screen_has("1-T:16"));
+	go_idle();
+}
+
+/**
+ * @brief Switching profiles before the autosave ran writes the edits of the profile in use first, and
+ * leaves no save pending.
+ */
+static void test_switch_saves_edits()
+{
+	open_first_period();
+	turn(1); // BACK -> TIME
+	app_on_click();
+	turn(1);
+	TEST_CHECK(screen_has("TIME:17"));
+	app_on_click();
+	turn(-1);
+	app_on_click(); // BACK commits
+	turn(-1);		// period 1 -> BACK
+	app_on_click();
+	TEST_CHECK(on_state_screen());
+
+	turn(1);
+	TEST_CHECK(on_profile_browser());
+	app_on_click();
+	TEST_EQUAL(strcmp(state_profile(), "FLOWER"), 0);
+	TEST_CHECK(!storage_save_pending());
+	profile_t stored;
+	period_t  period;
+	TEST_CHECK(storage_peek(0, &stored));
+	profile_get_period(&stored, 0, &period);
+	TEST_EQUAL(period.duration, 17 * 60);
+
+	turn(-1);
+	app_on_click();
+	TEST_EQUAL(strcmp(state_profile(), "VEG"), 0);
+	go_idle();
+}
+
+/**
+ * @brief TIME SHIFT from the top menu: the shift is applied and logged on the click that leaves the screen.
+ */
+static void test_time_shift()
+{
+	turn(-1);
+	TEST_CHECK(on_top_menu());
+	app_on_click();
+	TEST_CHECK(screen_has("SHIFT HOURS:"));
+	turn(3);
+	TEST_CHECK(screen_has("+3"));
+	app_on_click();
+	TEST_CHECK(on_top_menu());
+	check_last_event(JOURNAL_TIME_SHIFT, 3);
+	go_idle();
+}
+
+/**
+ * @brief DIAG from the top menu lists the counters and scrolls to the ones below the screen.
+ */
+static void test_diag()
+{
+	turn(-1);
+	TEST_CHECK(on_top_menu());
+	for(int i = 0; i < 7; i++) // TIME SHIFT -> DIAG
+	{
+		turn(1);
+	}
+	app_on_click();
+	TEST_CHECK(screen_has("FLASH ERASES"));
+	TEST_CHECK(!screen_has("ADC OVERRUNS"));
+	turn(5);
+	TEST_CHECK(screen_has("STATE CALC"));
+	TEST_CHECK(screen_has("ADC OVERRUNS"));
+	TEST_CHECK(!screen_has("FLASH ERASES"));
+	turn(-5);
+	TEST_CHECK(screen_has("FLASH ERASES"));
+	app_on_click();
+	TEST_CHECK(screen_has(">") && screen_has("DIAG")); // back on the top menu, scrolled to DIAG
+	go_idle();
+}
+
+/**
+ * @brief A click draws one frame: SAVE from the top menu shows its message and nothing draws over it.
+ */
+static void test_click_frames()
+{
+	turn(-1);
+	TEST_CHECK(on_top_menu());
+	turn(2); // TIME SHIFT -> SAVE
+	TEST_CHECK(screen_has("SAVE"));
+	int before = frames;
+	app_on_click();
+	TEST_EQUAL(frames, before + 1);
+	TEST_CHECK(screen_has("UNCHANGED"));
+
+	run_ms(2100); // the message stays for APP_MESSAGE_MS
+	TEST_CHECK(on_state_screen());
+	before = frames;
+	app_on_click(); // opens "Edit Profile", drawn by `app_on_click()` itself
+	TEST_EQUAL(frames, before + 1);
+	TEST_CHECK(on_edit_profile());
+	app_on_click(); // BACK
+	go_idle();
+}
+
+/**
+ * @brief Times `app_tick()` on the state screen between minute ticks, which is the timebase read and the
+ * schedule evaluation. Host figures only, the device reports its own on the STATE CALC line of DIAG.
+ */
+static void test_tick_cost()
+{
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int i = 0; i < 1000000; i++)
+	{
+		app_tick();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+	printf("app_tick() %.2f ns per call\n", ns / 1000000);
+	TEST_CHECK(on_state_screen());
+}
+
+int main()
+{
+	TEST_RUN(test_boot);
+	TEST_RUN(test_browse);
+	TEST_RUN(test_switch_profile);
+	TEST_RUN(test_edit_commit);
+	TEST_RUN(test_edit_cancel);
+	TEST_RUN(test_switch_saves_edits);
+	TEST_RUN(test_time_shift);
+	TEST_RUN(test_diag);
+	TEST_RUN(test_click_frames);
+	TEST_RUN(test_tick_cost);
+	return TEST_RESULT();
+}
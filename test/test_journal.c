@@ -0,0 +1,178 @@
+#include <string.h>
+#include "host.h"
+#include "journal.h"
+#include "task.h"
+#include "test.h"
+
+#define SECTOR_EVENTS	 (FLASH_SECTOR_SIZE / sizeof(journal_event_t))
+#define PAGE_EVENTS		 (FLASH_PAGE_SIZE / sizeof(journal_event_t))
+#define JOURNAL_CAPACITY (JOURNAL_SECTORS * SECTOR_EVENTS)
+
+/**
+ * @brief Checks that the journal holds the events with arguments `first` to `last`, newest first.
+ */
+static void check_events(int first, int last)
+{
+	TEST_EQUAL(journal_count(), last - first + 1);
+	for(int age = 0; age < journal_count(); age++)
+	{
+		journal_event_t event;
+		TEST_CHECK(journal_read(age, &event));
+		if(event.arg != (int16_t) (last - age))
+		{
+			TEST_EQUAL(event.arg, (int16_t) (last - age));
+			break;
+		}
+	}
+	journal_event_t event;
+	TEST_CHECK(!journal_read(journal_count(), &event));
+}
+
+/**
+ * @brief Logs an event and checks that it touches no flash, then runs the main loop pass after it.
+ */
+static void log_and_run(journal_event_id_t type, int arg)
+{
+	uint32_t programmed = host_flash_programmed;
+	uint32_t erases		= host_flash_erases;
+	journal_log(type, arg);
+	if(host_flash_programmed != programmed || host_flash_erases != erases)
+	{
+		TEST_CHECK(!"journal_log() wrote flash");
+	}
+	task_run();
+}
+
+/**
+ * @brief Logs events until the journal has wrapped three times. Every event is programmed exactly once,
+ * in full pages by the flush task, and each sector is erased once per pass. The sector ahead of the newest
+ * event is always erased, so the journal keeps between 3 and 4 sectors of events.
+ */
+static void test_wrap()
+{
+	host_flash_reset();
+	journal_init(); // logs JOURNAL_BOOT, arg 0
+	int logged = 1;
+	for(; logged < 3 * JOURNAL_CAPACITY + PAGE_EVENTS / 2; logged++)
+	{
+		log_and_run(JOURNAL_PROFILE, (int16_t) logged);
+		TEST_CHECK(journal_count() < JOURNAL_CAPACITY);
+	}
+	task_run(); // the last sector erase takes a pass of its own
+	int newest = logged - 1;
+	int kept   = (JOURNAL_SECTORS - 1) * SECTOR_EVENTS + newest % SECTOR_EVENTS + 1;
+	check_events(newest - kept + 1, newest);
+
+	uint32_t flushed = logged - logged % PAGE_EVENTS;
+	TEST_EQUAL(host_flash_programmed, flushed * sizeof(journal_event_t));
+	TEST_EQUAL(host_flash_erases, logged / SECTOR_EVENTS);
+	printf("  %d events: %lu bytes programmed, write amplification %.2f, %lu sector erases\n", logged,
+		   (unsigned long) host_flash_programmed,
+		   (double) host_flash_programmed / (flushed * sizeof(journal_event_t)),
+		   (unsigned long) host_flash_erases);
+}
+
+/**
+ * @brief A burst of events within one main loop pass fills the queued page and the next one. Further events
+ * are dropped, and the flush task writes both pages on the next passes without waiting for the timer.
+ */
+static void test_burst()
+{
+	host_flash_reset();
+	journal_init();
+	journal_flush();
+	host_flash_programmed = 0;
+
+	int room = 2 * PAGE_EVENTS - 1; // the boot event is in the first page
+	for(int i = 1; i <= room + 5; i++)
+	{
+		journal_log(JOURNAL_ALARM, i);
+	}
+	TEST_EQUAL(host_flash_programmed, 0);
+	check_events(0, room);
+
+	task_run();
+	TEST_EQUAL(host_flash_programmed, FLASH_PAGE_SIZE);
+	task_run();
+	TEST_EQUAL(host_flash_programmed, 2 * FLASH_PAGE_SIZE);
+	task_run();
+	TEST_EQUAL(host_flash_programmed, 2 * FLASH_PAGE_SIZE); // nothing left
+	check_events(0, room);
+
+	journal_init();
+	TEST_EQUAL(journal_count(), room + 2);
+}
+
+/**
+ * @brief After a reboot the journal continues behind the newest flushed event with the next boot number.
+ * Staged events that were not flushed are lost. A region without any erased slot is erased as a whole.
+ */
+static void test_reboot()
+{
+	host_flash_reset();
+	journal_init();
+	for(int i = 1; i < SECTOR_EVENTS + 10; i++)
+	{
+		log_and_run(JOURNAL_PROFILE, i);
+	}
+	journal_flush();
+	journal_log(JOURNAL_PROFILE, SECTOR_EVENTS + 10); // never flushed
+
+	journal_init();
+	journal_event_t event;
+	TEST_EQUAL(journal_count(), SECTOR_EVENTS + 11);
+	TEST_CHECK(journal_read(0, &event));
+	TEST_EQUAL(event.type, JOURNAL_BOOT);
+	TEST_EQUAL(event.boot, 1);
+	TEST_EQUAL(event.arg, 1);
+	TEST_CHECK(journal_read(1, &event));
+	TEST_EQUAL(event.arg, SECTOR_EVENTS + 9);
+	TEST_EQUAL(event.boot, 0);
+
+	memset(host_flash + JOURNAL_OFFSET, 0, JOURNAL_SECTORS * FLASH_SECTOR_SIZE); // not a journal at all
+	host_flash_erases = 0;
+	journal_init();
+	TEST_EQUAL(host_flash_erases, JOURNAL_SECTORS);
+	TEST_EQUAL(journal_count(), 1);
+}
+
+/**
+ * @brief Single events are flushed by the task `JOURNAL_FLUSH_MS` after they were logged. Each flush
+ * programs the whole page again, which is the worst case: one page per event and still no erase.
+ */
+static void test_flush_timer()
+{
+	host_flash_reset();
+	journal_init();
+	journal_flush();
+	host_flash_programmed = 0;
+
+	int events = PAGE_EVENTS / 2;
+	for(int i = 1; i <= events; i++)
+	{
+		journal_log(JOURNAL_SAVE, i);
+		task_run();
+		TEST_EQUAL(host_flash_programmed, (i - 1) * FLASH_PAGE_SIZE); // not yet
+		host_time_us += JOURNAL_FLUSH_MS * 1000;
+		task_run();
+		TEST_EQUAL(host_flash_programmed, i * FLASH_PAGE_SIZE);
+	}
+	TEST_EQUAL(host_flash_erases, 0);
+	printf("  %d events flushed one by one: write amplification %.2f\n", events,
+		   (double) host_flash_programmed / (events * sizeof(journal_event_t)));
+
+	journal_init();
+	journal_event_t event;
+	TEST_EQUAL(journal_count(), 1 + events + 1);
+	TEST_CHECK(journal_read(1, &event));
+	TEST_EQUAL(event.arg, events);
+}
+
+int main()
+{
+	TEST_RUN(test_wrap);
+	TEST_RUN(test_burst);
+	TEST_RUN(test_reboot);
+	TEST_RUN(test_flush_timer);
+	return TEST_RESULT();
+}
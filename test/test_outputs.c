@@ -0,0 +1,213 @@
+#include "hardware/pwm.h"
+#include "host.h"
+#include "outputs.h"
+#include "pins.h"
+#include "power.h"
+#include "test.h"
+
+static const uint32_t led_mw[OUTPUT_LED_COUNT] = {
+	[OUTPUT_LED_WHITE_RED] = OUTPUT_LED_WHITE_RED_MW,
+	[OUTPUT_LED_BLUE]	   = OUTPUT_LED_BLUE_MW,
+};
+
+static power_clock_listener_t clock_listener = NULL; // registered by `outputs_init()`
+
+/**
+ * @brief Keeps the listener outputs.c registers, the tests call it to switch the clock.
+ */
+void power_add_clock_listener(power_clock_listener_t listener)
+{
+	clock_listener = listener;
+}
+
+/**
+ * @brief Estimated LED load of a set of levels, computed like `outputs_limit_power()` does.
+ */
+static uint32_t load_mw(const uint32_t levels[OUTPUT_LED_COUNT])
+{
+	uint32_t load = 0;
+	for(int i = 0; i < OUTPUT_LED_COUNT; i++)
+	{
+		load += (levels[i] * (uint64_t) led_mw[i]) >> 16;
+	}
+	return load;
+}
+
+/**
+ * @brief Levels that fit the budget pass unchanged.
+ */
+static void test_limit_within_budget()
+{
+	uint32_t requested[OUTPUT_LED_COUNT] = {OUTPUT_LEVEL_FROM_PERCENT(50), OUTPUT_LEVEL_MAX};
+	uint32_t levels[OUTPUT_LED_COUNT];
+	TEST_EQUAL(outputs_limit_power(requested, true, levels), OUTPUT_LEVEL_MAX);
+	TEST_EQUAL(levels[OUTPUT_LED_WHITE_RED], requested[OUTPUT_LED_WHITE_RED]);
+	TEST_EQUAL(levels[OUTPUT_LED_BLUE], requested[OUTPUT_LED_BLUE]);
+
+	uint32_t off[OUTPUT_LED_COUNT] = {0, 0};
+	TEST_EQUAL(outputs_limit_power(off, true, levels), OUTPUT_LEVEL_MAX);
+	TEST_EQUAL(levels[OUTPUT_LED_WHITE_RED], 0);
+	TEST_EQUAL(levels[OUTPUT_LED_BLUE], 0);
+}
+
+/**
+ * @brief Everything at 100% is scaled to the budget, and the pump's load is reserved before the LEDs'.
+ */
+static void test_limit_full_load()
+{
+	uint32_t requested[OUTPUT_LED_COUNT] = {OUTPUT_LEVEL_MAX, OUTPUT_LEVEL_MAX};
+	uint32_t levels[OUTPUT_LED_COUNT];
+	uint32_t full_mw = OUTPUT_LED_WHITE_RED_MW + OUTPUT_LED_BLUE_MW;
+
+	uint32_t scale = outputs_limit_power(requested, false, levels);
+	TEST_EQUAL(scale, ((uint64_t) OUTPUT_POWER_BUDGET_MW << 16) / full_mw);
+	TEST_CHECK(load_mw(levels) <= OUTPUT_POWER_BUDGET_MW);
+
+	scale = outputs_limit_power(requested, true, levels);
+	TEST_EQUAL(scale, ((uint64_t) (OUTPUT_POWER_BUDGET_MW - OUTPUT_PUMP_MW) << 16) / full_mw);
+	TEST_CHECK(load_mw(levels) + OUTPUT_PUMP_MW <= OUTPUT_POWER_BUDGET_MW);
+	TEST_EQUAL(levels[OUTPUT_LED_WHITE_RED], levels[OUTPUT_LED_BLUE]); // same factor, same color mix
+}
+
+/**
+ * @brief Over a grid of levels the limited load never exceeds the budget, and a scaled load falls short of
+ * it by no more than the rounding: 1 mW per channel in the load estimate and 1 mW per channel in the levels.
+ */
+static void test_limit_sweep()
+{
+	for(int pump = 0; pump < 2; pump++)
+	{
+		uint32_t available = OUTPUT_POWER_BUDGET_MW - (pump ? OUTPUT_PUMP_MW : 0);
+		for(uint32_t a = 0; a <= OUTPUT_LEVEL_MAX; a += OUTPUT_LEVEL_MAX / 64)
+		{
+			for(uint32_t b = 0; b <= OUTPUT_LEVEL_MAX; b += OUTPUT_LEVEL_MAX / 64)
+			{
+				uint32_t requested[OUTPUT_LED_COUNT] = {a, b};
+				uint32_t levels[OUTPUT_LED_COUNT];
+				uint32_t scale = outputs_limit_power(requested, pump, levels);
+				TEST_CHECK(scale <= OUTPUT_LEVEL_MAX);
+				TEST_CHECK(load_mw(levels) <= available);
+				if(scale < OUTPUT_LEVEL_MAX)
+				{
+					TEST_CHECK(load_mw(levels) + 2 * OUTPUT_LED_COUNT >= available);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Output level of an LED channel at a PWM counter value, like the slice drives the pin.
+ *
+ * A channel is high while the counter is below its compare value, or at or above it with inverted
+ * polarity, which `outputs_configure_polarity()` sets on end-aligned channels.
+ */
+static bool pwm_output(int led, uint32_t compare, uint32_t counter)
+{
+	return outputs_end_aligned(led) ? counter >= compare : counter < compare;
+}
+
+/**
+ * @brief Simulates a PWM period for every pair of on-steps: each channel stays on for its on-steps, and the
+ * two overlap only by what their duty cycles add up to above 100% (by the shorter pulse without stagger).
+ */
+static void test_stagger_overlap()
+{
+	const uint32_t period = 64;
+	for(uint32_t a = 0; a <= period; a++)
+	{
+		for(uint32_t b = 0; b <= period; b++)
+		{
+			uint32_t compare_a = outputs_compare_value(OUTPUT_LED_WHITE_RED, a, period);
+			uint32_t compare_b = outputs_compare_value(OUTPUT_LED_BLUE, b, period);
+			uint32_t on_a	   = 0;
+			uint32_t on_b	   = 0;
+			uint32_t overlap   = 0;
+			for(uint32_t counter = 0; counter < period; counter++)
+			{
+				bool high_a = pwm_output(OUTPUT_LED_WHITE_RED, compare_a, counter);
+				bool high_b = pwm_output(OUTPUT_LED_BLUE, compare_b, counter);
+				on_a	 += high_a;
+				on_b	 += high_b;
+				overlap	 += high_a && high_b;
+			}
+			TEST_EQUAL(on_a, a);
+			TEST_EQUAL(on_b, b);
+			TEST_EQUAL(overlap, OUTPUT_STAGGER ? (a + b > period ? a + b - period : 0) : MIN(a, b));
+		}
+	}
+}
+
+/**
+ * @brief With `OUTPUT_STAGGER` the blue pulse is end-aligned, at the PWM frequency's real period too.
+ */
+static void test_stagger_alignment()
+{
+	const uint32_t period = 125000000 / OUTPUT_PWM_FREQ_HZ;
+	const uint32_t blue	  = OUTPUT_STAGGER ? period - period / 4 : period / 4;
+	TEST_CHECK(!outputs_end_aligned(OUTPUT_LED_WHITE_RED));
+	TEST_EQUAL(outputs_end_aligned(OUTPUT_LED_BLUE), OUTPUT_STAGGER);
+	TEST_EQUAL(outputs_compare_value(OUTPUT_LED_WHITE_RED, period / 4, period), period / 4);
+	TEST_EQUAL(outputs_compare_value(OUTPUT_LED_BLUE, period / 4, period), blue);
+	TEST_EQUAL(outputs_compare_value(OUTPUT_LED_BLUE, 0, period), OUTPUT_STAGGER ? period : 0); // off stays off
+}
+
+/**
+ * @brief Returns the PWM steps per period a LED pin is high for, from the slice registers.
+ */
+static uint32_t led_on_steps(int led, uint gpio)
+{
+	pwm_slice_hw_t* slice	= &pwm_hw->slice[pwm_gpio_to_slice_num(gpio)];
+	uint32_t		compare = pwm_gpio_to_channel(gpio) == PWM_CHAN_B ? slice->cc >> 16 : slice->cc & 0xFFFF;
+	return outputs_end_aligned(led) ? slice->top + 1 - compare : compare;
+}
+
+/**
+ * @brief Switches the system clock like the power manager does and checks the PWM timing derived for it:
+ * divider 1, an exact `OUTPUT_PWM_FREQ_HZ` period, and the LED levels rescaled to the new period.
+ */
+static void check_clock_point(uint32_t khz, const uint32_t levels[OUTPUT_LED_COUNT])
+{
+	printf("  %lu kHz\n", (unsigned long) khz);
+	host_sys_hz = khz * 1000;
+	clock_listener(host_sys_hz);
+
+	uint32_t		period = khz * 1000 / OUTPUT_PWM_FREQ_HZ;
+	pwm_slice_hw_t* slice  = &pwm_hw->slice[pwm_gpio_to_slice_num(PIN_LED_WHITE_RED)];
+	TEST_EQUAL(slice->div, 1 << 4);
+	TEST_EQUAL(slice->top, period - 1);
+	TEST_EQUAL(outputs_pwm_frequency(), OUTPUT_PWM_FREQ_HZ);
+	TEST_EQUAL(host_sys_hz / ((slice->div >> 4) * (slice->top + 1)), OUTPUT_PWM_FREQ_HZ);
+	TEST_EQUAL(led_on_steps(OUTPUT_LED_WHITE_RED, PIN_LED_WHITE_RED), (levels[0] * period) >> 16);
+	TEST_EQUAL(led_on_steps(OUTPUT_LED_BLUE, PIN_LED_BLUE), (levels[1] * period) >> 16);
+}
+
+/**
+ * @brief The PWM frequency is exact at every clock point, and a duty cycle set at one clock point is kept
+ * across switches to the other and back.
+ */
+static void test_clock_points()
+{
+	host_sys_hz = POWER_CLOCK_ACTIVE_KHZ * 1000;
+	outputs_init();
+	TEST_CHECK(clock_listener != NULL);
+
+	uint32_t levels[OUTPUT_LED_COUNT] = {OUTPUT_LEVEL_FROM_PERCENT(30), OUTPUT_LEVEL_FROM_PERCENT(70)};
+	outputs_set_led_levels(levels);
+	TEST_EQUAL(outputs_budget_scale(), OUTPUT_LEVEL_MAX);
+
+	check_clock_point(POWER_CLOCK_ACTIVE_KHZ, levels);
+	check_clock_point(POWER_CLOCK_IDLE_KHZ, levels);
+	check_clock_point(POWER_CLOCK_ACTIVE_KHZ, levels);
+}
+
+int main()
+{
+	TEST_RUN(test_limit_within_budget);
+	TEST_RUN(test_limit_full_load);
+	TEST_RUN(test_limit_sweep);
+	TEST_RUN(test_stagger_overlap);
+	TEST_RUN(test_stagger_alignment);
+	TEST_RUN(test_clock_points);
+	return TEST_RESULT();
+}
@@ -0,0 +1,253 @@
+#include "alarms.h"
+#include "power.h"
+#include "pump_monitor.h"
+#include "sensors.h"
+#include "test.h"
+
+#define SETTLE_BATCHES (PUMP_CURRENT_SETTLE_MS / SENSOR_PERIOD_MS) // batches skipped after switching on
+#define TRACE_SAMPLES  16										   // ADC samples per batch in the replay
+
+// pump_monitor.c is linked for its pure functions, the tasks are never started.
+
+bool outputs_pump_is_on()
+{
+	return false;
+}
+
+void power_add_clock_listener(power_clock_listener_t listener)
+{
+}
+
+// Recorded pump current, one mean per `SENSOR_PERIOD_MS` batch from the moment the pump is switched on.
+
+static const uint16_t trace_normal[] = {
+	2400, 1800, 1100, 700, 640, 610, 590, 620, 600, 580, 605, 615,
+	595, 600, 610, 590, 600, 620, 610, 600, 590, 605, 600, 610,
+};
+
+static const uint16_t trace_dry_run[] = {
+	600, 300, 180, 120, 110, 95, 120, 105, 100, 115, 90, 110,
+	100, 105, 98, 102, 100, 110, 105, 95, 100, 108, 102, 99,
+};
+
+static const uint16_t trace_stall[] = {
+	2400, 2100, 2000, 1950, 1900, 1950, 2000, 1900, 1950, 1980, 1920, 1900,
+	1950, 1900, 1950, 1980, 1930, 1950, 1900, 1960, 1940, 1950, 1920, 1900,
+};
+
+static const uint16_t trace_overcurrent[] = {
+	2400, 1800, 1100, 700, 620, 600, 610, 600, 3200, 3300, 3250, 3200,
+	3300, 3250, 3200, 3300, 3250, 3200, 3300, 3250, 3200, 3300, 3250, 3200,
+};
+
+// A normal run with a half second dip and a spike, both shorter than the window.
+static const uint16_t trace_glitches[] = {
+	2400, 1800, 1100, 700, 600, 610, 590, 620, 0, 20, 600, 610,
+	590, 600, 2400, 610, 600, 590, 620, 600, 610, 600, 590, 605,
+};
+
+/**
+ * @struct replay_t
+ * @brief Alarms a trace raised: the first batch each became active on, -1 if it never did.
+ */
+typedef struct
+{
+	int first[ALARM_COUNT];
+	int last_fault; // fault reported for the last batch
+} replay_t;
+
+/**
+ * @brief Replays a trace like the firmware: the filtered current sense voltage against the overcurrent
+ * threshold, see sensors.c, and the current window against the dry run and stall thresholds, see
+ * `pump_current_task_fn()`. The filter runs on millivolts here instead of ADC counts; it is linear, so
+ * the alarms trip on the same batch.
+ */
+static replay_t replay(const uint16_t* trace, int count)
+{
+	replay_t			  result = {.last_fault = PUMP_FAULT_NONE};
+	pump_current_window_t window;
+	sensor_filter_t		  filter	  = {0};
+	bool				  overcurrent = false;
+	for(int i = 0; i < ALARM_COUNT; i++)
+	{
+		result.first[i] = -1;
+	}
+
+	pump_current_reset(&window);
+	sensor_filter_update(&filter, 0, TRACE_SAMPLES); // pump off before the trace
+	for(int batch = 0; batch < count; batch++)
+	{
+		uint32_t mv = trace[batch] * PUMP_CURRENT_MV_PER_A / 1000;
+		sensor_filter_update(&filter, mv * TRACE_SAMPLES, TRACE_SAMPLES);
+		overcurrent = sensor_threshold_check(sensor_filter_value(&filter), SENSOR_PUMP_CURRENT_TRIP_MV,
+											 SENSOR_PUMP_CURRENT_CLEAR_MV, overcurrent);
+
+		pump_fault_t fault = pump_current_update(&window, trace[batch], SENSOR_PERIOD_MS);
+		bool		 active[ALARM_COUNT] = {
+			[ALARM_PUMP_OVERCURRENT] = overcurrent,
+			[ALARM_PUMP_DRY_RUN]	 = fault == PUMP_FAULT_DRY_RUN,
+			[ALARM_PUMP_STALL]		 = fault == PUMP_FAULT_STALL,
+		};
+		for(int i = 0; i < ALARM_COUNT; i++)
+		{
+			if(active[i] && result.first[i] < 0)
+			{
+				result.first[i] = batch;
+			}
+		}
+		result.last_fault = fault;
+	}
+	return result;
+}
+
+/**
+ * @brief A loaded pump raises nothing, the inrush is skipped.
+ */
+static void test_trace_normal()
+{
+	replay_t r = replay(trace_normal, count_of(trace_normal));
+	TEST_EQUAL(r.first[ALARM_PUMP_OVERCURRENT], -1);
+	TEST_EQUAL(r.first[ALARM_PUMP_DRY_RUN], -1);
+	TEST_EQUAL(r.first[ALARM_PUMP_STALL], -1);
+}
+
+/**
+ * @brief An unloaded pump raises DRY RUN as soon as the first full window after the inrush is judged.
+ */
+static void test_trace_dry_run()
+{
+	replay_t r = replay(trace_dry_run, count_of(trace_dry_run));
+	TEST_EQUAL(r.first[ALARM_PUMP_DRY_RUN], SETTLE_BATCHES + PUMP_CURRENT_WINDOW - 1);
+	TEST_EQUAL(r.first[ALARM_PUMP_OVERCURRENT], -1);
+	TEST_EQUAL(r.first[ALARM_PUMP_STALL], -1);
+	TEST_EQUAL(r.last_fault, PUMP_FAULT_DRY_RUN);
+}
+
+/**
+ * @brief A blocked rotor draws less than the overcurrent threshold, only PUMP STALL is raised.
+ */
+static void test_trace_stall()
+{
+	replay_t r = replay(trace_stall, count_of(trace_stall));
+	TEST_EQUAL(r.first[ALARM_PUMP_STALL], SETTLE_BATCHES + PUMP_CURRENT_WINDOW - 1);
+	TEST_EQUAL(r.first[ALARM_PUMP_OVERCURRENT], -1);
+	TEST_EQUAL(r.first[ALARM_PUMP_DRY_RUN], -1);
+	TEST_EQUAL(r.last_fault, PUMP_FAULT_STALL);
+}
+
+/**
+ * @brief A short from batch 8 on, at the 3.3 V limit of the sense input: PUMP STALL comes with the batch
+ * that fills the window, PUMP CURRENT once the filtered voltage has passed its trip threshold.
+ */
+static void test_trace_overcurrent()
+{
+	replay_t r = replay(trace_overcurrent, count_of(trace_overcurrent));
+	TEST_EQUAL(r.first[ALARM_PUMP_STALL], SETTLE_BATCHES + PUMP_CURRENT_WINDOW - 1);
+	TEST_EQUAL(r.first[ALARM_PUMP_OVERCURRENT], 12);
+	TEST_EQUAL(r.first[ALARM_PUMP_DRY_RUN], -1);
+	TEST_EQUAL(r.last_fault, PUMP_FAULT_STALL);
+}
+
+/**
+ * @brief A dip to zero and a spike shorter than the window are averaged out.
+ */
+static void test_trace_glitches()
+{
+	replay_t r = replay(trace_glitches, count_of(trace_glitches));
+	TEST_EQUAL(r.first[ALARM_PUMP_OVERCURRENT], -1);
+	TEST_EQUAL(r.first[ALARM_PUMP_DRY_RUN], -1);
+	TEST_EQUAL(r.first[ALARM_PUMP_STALL], -1);
+}
+
+/**
+ * @brief Feeds `count` batches of `current_ma` and returns the fault of the last one.
+ */
+static pump_fault_t feed(pump_current_window_t* window, uint32_t current_ma, int count)
+{
+	pump_fault_t fault = PUMP_FAULT_NONE;
+	for(int i = 0; i < count; i++)
+	{
+		fault = pump_current_update(window, current_ma, SENSOR_PERIOD_MS);
+	}
+	return fault;
+}
+
+/**
+ * @brief Batches up to and including `PUMP_CURRENT_SETTLE_MS` are skipped, the first judgement comes with
+ * the batch that fills the window.
+ */
+static void test_settle_and_debounce()
+{
+	pump_current_window_t window;
+	pump_current_reset(&window);
+	TEST_EQUAL(feed(&window, 0, SETTLE_BATCHES), PUMP_FAULT_NONE);
+	TEST_EQUAL(window.count, 0);
+	TEST_EQUAL(feed(&window, 0, PUMP_CURRENT_WINDOW - 1), PUMP_FAULT_NONE);
+	TEST_EQUAL(window.count, PUMP_CURRENT_WINDOW - 1);
+	TEST_EQUAL(feed(&window, 0, 1), PUMP_FAULT_DRY_RUN);
+
+	pump_current_reset(&window); // switched off and on again
+	TEST_EQUAL(window.fault, PUMP_FAULT_NONE);
+	TEST_EQUAL(feed(&window, 5000, SETTLE_BATCHES + PUMP_CURRENT_WINDOW - 1), PUMP_FAULT_NONE);
+	TEST_EQUAL(feed(&window, 5000, 1), PUMP_FAULT_STALL);
+}
+
+/**
+ * @brief The thresholds trip on the exact window average: 150 mA is fine, 1/8 mA less is a dry run;
+ * 1500 mA is fine, 1/8 mA more is a stall.
+ */
+static void test_thresholds()
+{
+	pump_current_window_t window;
+	pump_current_reset(&window);
+	feed(&window, 0, SETTLE_BATCHES);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_MA, PUMP_CURRENT_WINDOW), PUMP_FAULT_NONE);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_MA - 1, 1), PUMP_FAULT_DRY_RUN);
+
+	pump_current_reset(&window);
+	feed(&window, 0, SETTLE_BATCHES);
+	TEST_EQUAL(feed(&window, PUMP_STALL_MA, PUMP_CURRENT_WINDOW), PUMP_FAULT_NONE);
+	TEST_EQUAL(feed(&window, PUMP_STALL_MA + 1, 1), PUMP_FAULT_STALL);
+}
+
+/**
+ * @brief A fault holds until the average crosses its clear threshold, and trips again only below or
+ * above the trip threshold.
+ */
+static void test_hysteresis()
+{
+	pump_current_window_t window;
+	pump_current_reset(&window);
+	feed(&window, 0, SETTLE_BATCHES);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_MA - 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_DRY_RUN);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_MA + 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_DRY_RUN);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_CLEAR_MA - 1, PUMP_CURRENT_WINDOW), PUMP_FAULT_DRY_RUN);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_CLEAR_MA, PUMP_CURRENT_WINDOW), PUMP_FAULT_NONE);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_MA + 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_NONE);
+	TEST_EQUAL(feed(&window, PUMP_DRY_RUN_MA - 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_DRY_RUN);
+
+	pump_current_reset(&window);
+	feed(&window, 0, SETTLE_BATCHES);
+	TEST_EQUAL(feed(&window, PUMP_STALL_MA + 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_STALL);
+	TEST_EQUAL(feed(&window, PUMP_STALL_MA - 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_STALL);
+	TEST_EQUAL(feed(&window, PUMP_STALL_CLEAR_MA + 1, PUMP_CURRENT_WINDOW), PUMP_FAULT_STALL);
+	TEST_EQUAL(feed(&window, PUMP_STALL_CLEAR_MA, PUMP_CURRENT_WINDOW), PUMP_FAULT_NONE);
+	TEST_EQUAL(feed(&window, PUMP_STALL_MA - 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_NONE);
+
+	// a stall that ends in a dry run clears on the way down and trips again
+	TEST_EQUAL(feed(&window, PUMP_STALL_MA + 10, PUMP_CURRENT_WINDOW), PUMP_FAULT_STALL);
+	TEST_EQUAL(feed(&window, 0, PUMP_CURRENT_WINDOW), PUMP_FAULT_DRY_RUN);
+}
+
+int main()
+{
+	TEST_RUN(test_trace_normal);
+	TEST_RUN(test_trace_dry_run);
+	TEST_RUN(test_trace_stall);
+	TEST_RUN(test_trace_overcurrent);
+	TEST_RUN(test_trace_glitches);
+	TEST_RUN(test_settle_and_debounce);
+	TEST_RUN(test_thresholds);
+	TEST_RUN(test_hysteresis);
+	return TEST_RESULT();
+}
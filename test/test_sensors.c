@@ -0,0 +1,94 @@
+#include "sensors.h"
+#include "test.h"
+
+/**
+ * @brief The first batch loads the filter, later ones move it 1/2^SENSOR_FILTER_SHIFT of the way.
+ */
+static void test_filter_step()
+{
+	sensor_filter_t filter = {0};
+	sensor_filter_update(&filter, 0, 0);
+	TEST_CHECK(!filter.primed);
+
+	sensor_filter_update(&filter, 1000 * 8, 8);
+	TEST_CHECK(filter.primed);
+	TEST_EQUAL(sensor_filter_value(&filter), 1000);
+
+	sensor_filter_update(&filter, 2000 * 8, 8);
+	TEST_EQUAL(sensor_filter_value(&filter), 1000 + (1000 >> SENSOR_FILTER_SHIFT));
+
+	sensor_filter_update(&filter, 0, 0); // an empty batch leaves the state alone
+	TEST_EQUAL(sensor_filter_value(&filter), 1000 + (1000 >> SENSOR_FILTER_SHIFT));
+
+	for(int i = 0; i < 40; i++)
+	{
+		sensor_filter_update(&filter, 2000 * 8, 8);
+	}
+	TEST_EQUAL(sensor_filter_value(&filter), 2000);
+
+	for(int i = 0; i < 40; i++)
+	{
+		sensor_filter_update(&filter, 10 * 8, 8);
+	}
+	TEST_EQUAL(sensor_filter_value(&filter), 10);
+}
+
+/**
+ * @brief Batch means keep `SENSOR_FILTER_FRAC` fractional bits and a full ring of full-scale samples fits.
+ */
+static void test_filter_mean()
+{
+	sensor_filter_t filter = {0};
+	sensor_filter_update(&filter, 1000 * 3 + 1001, 4); // 1000.25
+	TEST_EQUAL(filter.state, (4001 << SENSOR_FILTER_FRAC) / 4);
+	TEST_EQUAL(sensor_filter_value(&filter), 1000);
+
+	filter = (sensor_filter_t) {0};
+	sensor_filter_update(&filter, 1000 + 1001, 2); // 1000.5 rounds up
+	TEST_EQUAL(sensor_filter_value(&filter), 1001);
+
+	uint32_t samples = (1u << SENSOR_RING_BITS) / sizeof(uint16_t);
+	filter			 = (sensor_filter_t) {0};
+	sensor_filter_update(&filter, 4095 * samples, samples);
+	TEST_EQUAL(sensor_filter_value(&filter), 4095);
+}
+
+/**
+ * @brief A high alarm trips at `trip_mv` and holds until the voltage drops below `clear_mv`.
+ */
+static void test_threshold_high()
+{
+	uint32_t trip  = SENSOR_PUMP_CURRENT_TRIP_MV;
+	uint32_t clear = SENSOR_PUMP_CURRENT_CLEAR_MV;
+
+	TEST_CHECK(!sensor_threshold_check(trip - 1, trip, clear, false));
+	TEST_CHECK(sensor_threshold_check(trip, trip, clear, false));
+	TEST_CHECK(sensor_threshold_check(trip - 1, trip, clear, true));
+	TEST_CHECK(sensor_threshold_check(clear + 1, trip, clear, true));
+	TEST_CHECK(!sensor_threshold_check(clear, trip, clear, true));
+	TEST_CHECK(!sensor_threshold_check(clear + 1, trip, clear, false));
+}
+
+/**
+ * @brief A low alarm (trip below clear) trips at or below `trip_mv` and clears at `clear_mv`.
+ */
+static void test_threshold_low()
+{
+	uint32_t trip  = SENSOR_CHIP_HOT_TRIP_MV;
+	uint32_t clear = SENSOR_CHIP_HOT_CLEAR_MV;
+
+	TEST_CHECK(!sensor_threshold_check(trip + 1, trip, clear, false));
+	TEST_CHECK(sensor_threshold_check(trip, trip, clear, false));
+	TEST_CHECK(sensor_threshold_check(clear - 1, trip, clear, true));
+	TEST_CHECK(!sensor_threshold_check(clear, trip, clear, true));
+	TEST_CHECK(!sensor_threshold_check(clear - 1, trip, clear, false));
+}
+
+int main()
+{
+	TEST_RUN(test_filter_step);
+	TEST_RUN(test_filter_mean);
+	TEST_RUN(test_threshold_high);
+	TEST_RUN(test_threshold_low);
+	return TEST_RESULT();
+}
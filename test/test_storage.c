@@ -0,0 +1,328 @@
+#include <string.h>
+#include "host.h"
+#include "storage.h"
+#include "task.h"
+#include "test.h"
+
+#define TEST_CURRENT  2 // current profile index of the legacy image
+#define TEST_PROFILES 8 // profiles of the library the deferred save tests write to
+
+/**
+ * @brief Writes a little-endian int, the byte order of every multi-byte field on flash.
+ */
+static void put_int(uint8_t* data, int32_t value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+}
+
+/**
+ * @brief Writes a record byte by byte, see `PROFILE_RECORD_SIZE`.
+ */
+static void put_record(uint8_t* record, const char* name, int type, int latitude, int version, int periods,
+					   const period_packed_t* values)
+{
+	memset(record, 0, PROFILE_RECORD_SIZE);
+	strncpy((char*) record, name, PROFILE_NAME_LEN);
+	record[12] = type;
+	record[13] = latitude;
+	record[14] = version;
+	record[15] = periods;
+	for(int i = 0; i < periods; i++)
+	{
+		put_int(record + 16 + i * 4, values[i]);
+	}
+}
+
+/**
+ * @brief Period `k` of legacy profile `i`: long durations, levels up to 150% that must be clamped.
+ */
+static period_t legacy_period(int i, int k)
+{
+	return (period_t) {.duration = 60 * k + i, .led_white_red_power = k * 10 + i, .led_blue_power = 150 - k * 20};
+}
+
+/**
+ * @brief Builds the legacy save of the firmware before the library in the last flash sector, see
+ * `storage_read_legacy()` for the layout.
+ *
+ * Names use all 16 bytes of the old name field.
+ */
+static void put_legacy()
+{
+	host_flash_reset();
+	uint8_t* legacy = host_flash + STORAGE_LEGACY_OFFSET;
+	legacy[0]		= 0xA5;
+	legacy[1]		= 0x5A;
+	legacy[2]		= 0xA5;
+	legacy[3]		= 0x5A;
+	put_int(legacy + 4, TEST_CURRENT);
+
+	for(int i = 0; i < STORAGE_LEGACY_PROFILES; i++)
+	{
+		uint8_t* data = legacy + 8 + i * 88;
+		memcpy(data, "LEGACY PROFILE ", 16);
+		data[15] = '0' + i; // no terminator
+		data	+= 16;
+		for(int k = 0; k < MAX_PERIODS; k++, data += 12)
+		{
+			period_t period = legacy_period(i, k);
+			put_int(data, period.duration);
+			put_int(data + 4, period.led_white_red_power);
+			put_int(data + 8, period.led_blue_power);
+		}
+	}
+}
+
+/**
+ * @brief Checks the profiles read from the legacy image built by `put_legacy()`.
+ */
+static void check_legacy(const profile_t* profiles)
+{
+	for(int i = 0; i < STORAGE_LEGACY_PROFILES; i++)
+	{
+		const profile_t* profile = &profiles[i];
+		TEST_CHECK(strcmp(profile->name, "LEGACY PROF") == 0); // cut to 11 characters
+		TEST_EQUAL(profile->type, PROFILE_FIXED);
+		TEST_EQUAL(profile->latitude, 0);
+		for(int k = 0; k < MAX_PERIODS; k++)
+		{
+			period_t expected = legacy_period(i, k);
+			period_t period;
+			profile_get_period(profile, k, &period);
+			TEST_EQUAL(period.duration, expected.duration);
+			TEST_EQUAL(period.led_white_red_power, expected.led_white_red_power);
+			TEST_EQUAL(period.led_blue_power, MIN(expected.led_blue_power, PERIOD_LEVEL_MAX));
+		}
+	}
+}
+
+/**
+ * @brief A version 1 record decodes field by field and encodes back to the same bytes.
+ */
+static void test_decode_v1()
+{
+	period_packed_t periods[MAX_PERIODS] = {PERIOD_PACK(600, 40, 20), PERIOD_PACK(0, 0, 0),
+											PERIOD_PACK(PERIOD_DURATION_MAX, 100, 100)};
+	uint8_t			record[PROFILE_RECORD_SIZE];
+	put_record(record, "TOMATO", PROFILE_SUN, -40, 1, MAX_PERIODS, periods);
+
+	profile_t profile;
+	TEST_CHECK(profile_decode(record, &profile));
+	TEST_CHECK(strcmp(profile.name, "TOMATO") == 0);
+	TEST_EQUAL(profile.type, PROFILE_SUN);
+	TEST_EQUAL(profile.latitude, -40);
+	for(int i = 0; i < MAX_PERIODS; i++)
+	{
+		TEST_EQUAL(profile.periods[i], periods[i]);
+	}
+
+	uint8_t encoded[PROFILE_RECORD_SIZE];
+	profile_encode(&profile, encoded);
+	TEST_CHECK(memcmp(encoded, record, PROFILE_RECORD_SIZE) == 0);
+}
+
+/**
+ * @brief Records hold as many periods as they say. Missing periods are disabled, out of range values are
+ * sanitized, records of another version are rejected.
+ */
+static void test_decode_versions()
+{
+	period_packed_t periods[MAX_PERIODS] = {PERIOD_PACK(60, 127, 101), PERIOD_PACK(30, 5, 6), PERIOD_PACK(1, 2, 3),
+											PERIOD_PACK(4, 5, 6),	   PERIOD_PACK(7, 8, 9),  PERIOD_PACK(10, 11, 12)};
+	uint8_t			record[PROFILE_RECORD_SIZE];
+	profile_t		profile;
+
+	put_record(record, "SANITIZED", 9, 0, 1, MAX_PERIODS, periods);
+	TEST_CHECK(profile_decode(record, &profile));
+	TEST_EQUAL(profile.type, PROFILE_FIXED); // unknown type
+	TEST_EQUAL(profile.periods[0], PERIOD_PACK(60, 100, 100));
+	TEST_EQUAL(profile.periods[5], periods[5]);
+
+	put_record(record, "TWO PERIODS", 0, 0, 1, 2, periods);
+	memset(record + 16 + 2 * 4, 0xFF, PROFILE_RECORD_SIZE - 16 - 2 * 4); // past the periods, ignored
+	TEST_CHECK(profile_decode(record, &profile));
+	TEST_EQUAL(profile.periods[1], periods[1]);
+	TEST_EQUAL(profile.periods[2], 0);
+	TEST_EQUAL(profile.periods[5], 0);
+
+	put_record(record, "NO TERMINATOR", 0, 0, 1, 0, periods);
+	TEST_CHECK(profile_decode(record, &profile));
+	TEST_EQUAL(strlen(profile.name), PROFILE_NAME_LEN - 1);
+
+	put_record(record, "NEWER", 0, 0, PROFILE_RECORD_VERSION + 1, 1, periods);
+	TEST_CHECK(!profile_decode(record, &profile));
+	TEST_EQUAL(profile.name[0], '\0');
+
+	put_record(record, "ZEROED", 0, 0, 0, 1, periods);
+	TEST_CHECK(!profile_decode(record, &profile));
+
+	put_record(record, "TOO MANY", 0, 0, 1, 0, periods);
+	record[15] = (PROFILE_RECORD_SIZE - 16) / 4 + 1;
+	TEST_CHECK(!profile_decode(record, &profile));
+}
+
+/**
+ * @brief Reads the legacy image, then migrates it into the library and loads it back.
+ */
+static void test_legacy_image()
+{
+	put_legacy();
+	profile_t profiles[STORAGE_LEGACY_PROFILES];
+	int		  current = -1;
+	TEST_EQUAL(storage_read_legacy(profiles, &current), STORAGE_LEGACY_PROFILES);
+	TEST_EQUAL(current, TEST_CURRENT);
+	check_legacy(profiles);
+
+	TEST_CHECK(!storage_init());
+	TEST_CHECK(storage_format(profiles, STORAGE_LEGACY_PROFILES, current));
+	TEST_CHECK(storage_init());
+	TEST_EQUAL(storage_count(), STORAGE_LEGACY_PROFILES);
+	TEST_EQUAL(storage_current(), TEST_CURRENT);
+	for(int i = 0; i < STORAGE_LEGACY_PROFILES; i++)
+	{
+		profile_t profile;
+		TEST_CHECK(storage_load(i, &profile));
+		TEST_CHECK(memcmp(&profile, &profiles[i], sizeof(profile)) == 0);
+	}
+}
+
+/**
+ * @brief A sector without the legacy marker holds no legacy save.
+ */
+static void test_legacy_none()
+{
+	profile_t profiles[STORAGE_LEGACY_PROFILES];
+	int		  current = -1;
+
+	host_flash_reset();
+	TEST_EQUAL(storage_read_legacy(profiles, &current), 0);
+
+	put_legacy();
+	host_flash[STORAGE_LEGACY_OFFSET + 3] = 0x5B;
+	TEST_EQUAL(storage_read_legacy(profiles, &current), 0);
+	TEST_EQUAL(current, -1);
+}
+
+/**
+ * @brief Builds a profile with a single period of the given duration.
+ */
+static void make_profile(profile_t* profile, int index, int minutes)
+{
+	memset(profile, 0, sizeof(*profile));
+	snprintf(profile->name, sizeof(profile->name), "PROFILE %d", index);
+	period_t period = {.duration = minutes, .led_white_red_power = 50, .led_blue_power = 20};
+	profile_set_period(profile, 0, &period);
+}
+
+/**
+ * @brief Formats a library of `TEST_PROFILES` profiles, profile i lasting i minutes.
+ */
+static void format_library(profile_t* profiles)
+{
+	host_flash_reset();
+	for(int i = 0; i < TEST_PROFILES; i++)
+	{
+		make_profile(&profiles[i], i, i);
+	}
+	TEST_CHECK(!storage_init());
+	TEST_CHECK(storage_format(profiles, TEST_PROFILES, 0));
+	TEST_CHECK(storage_init());
+}
+
+/**
+ * @brief Checks that a profile loads with a valid CRC and equals `expected`.
+ */
+static void check_saved(int index, const profile_t* expected)
+{
+	profile_t profile;
+	TEST_CHECK(storage_load(index, &profile));
+	TEST_CHECK(memcmp(&profile, expected, sizeof(profile)) == 0);
+}
+
+/**
+ * @brief A deferred save does one flash operation per main loop pass: the sector erase and each program
+ * get a pass of their own. A read between them sees the sector whole, the neighbours of the record
+ * included.
+ */
+static void test_deferred_steps()
+{
+	profile_t profiles[TEST_PROFILES];
+	format_library(profiles);
+
+	make_profile(&profiles[1], 1, 1000); // sets bits, so the record sector is erased
+	storage_save_deferred(1, &profiles[1]);
+	uint32_t start_erases = host_flash_erases;
+	int		 passes		  = 0;
+	while(storage_save_pending())
+	{
+		uint32_t erases		= host_flash_erases;
+		uint32_t programmed = host_flash_programmed;
+		task_run();
+		passes++;
+		int operations = (host_flash_erases - erases) + (host_flash_programmed != programmed);
+		if(operations > 1)
+		{
+			TEST_EQUAL(operations, 1);
+			break;
+		}
+		if(host_flash_erases == start_erases + 1 && erases == start_erases)
+		{
+			check_saved(2, &profiles[2]); // record sector erased in flash, finished by the read
+		}
+		TEST_CHECK(passes < 20);
+	}
+	TEST_EQUAL(host_flash_erases - start_erases, 2); // the record sector, then the index sector
+	TEST_EQUAL(passes, 4);							  // the record program was done by the read
+	check_saved(1, &profiles[1]);
+	for(int i = 0; i < TEST_PROFILES; i++)
+	{
+		check_saved(i, &profiles[i]);
+	}
+}
+
+/**
+ * @brief Flushing a deferred save writes it at once, also when the task has already started on it, and
+ * nothing is left for the task. A synchronous save of another profile in between does not disturb it.
+ */
+static void test_deferred_flush()
+{
+	profile_t profiles[TEST_PROFILES];
+	format_library(profiles);
+
+	make_profile(&profiles[3], 3, 1500);
+	storage_save_deferred(3, &profiles[3]);
+	task_run(); // the record sector erase
+	make_profile(&profiles[5], 5, 1200);
+	TEST_CHECK(storage_save(5, &profiles[5]));
+	make_profile(&profiles[3], 3, 1600);
+	storage_save_deferred(3, &profiles[3]);
+	TEST_CHECK(storage_flush_deferred());
+	TEST_CHECK(!storage_save_pending());
+
+	uint32_t erases		= host_flash_erases;
+	uint32_t programmed = host_flash_programmed;
+	for(int i = 0; i < 10; i++)
+	{
+		task_run();
+	}
+	TEST_EQUAL(host_flash_erases, erases);
+	TEST_EQUAL(host_flash_programmed, programmed);
+	for(int i = 0; i < TEST_PROFILES; i++)
+	{
+		check_saved(i, &profiles[i]);
+	}
+}
+
+int main()
+{
+	TEST_RUN(test_decode_v1);
+	TEST_RUN(test_decode_versions);
+	TEST_RUN(test_legacy_image);
+	TEST_RUN(test_legacy_none);
+	TEST_RUN(test_deferred_steps);
+	TEST_RUN(test_deferred_flush);
+	return TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+#include <time.h>
+#include "host.h"
+#include "test.h"
+#include "timebase.h"
+
+#define BENCH_CALLS 10000000 // calls per benchmark loop
+
+static volatile uint64_t boot_us; // start of the 64-bit baseline, volatile so the division is not folded
+
+/**
+ * @brief Seconds since `boot_us` with a 64-bit division, as before the timebase.
+ */
+static uint32_t baseline_seconds()
+{
+	return (uint32_t) ((to_us_since_boot(get_absolute_time()) - boot_us) / 1000000);
+}
+
+/**
+ * @brief Minutes since `boot_us` the way the schedule computed them before the timebase: two 64-bit divisions.
+ */
+static uint32_t baseline_minutes()
+{
+	return (uint32_t) ((to_us_since_boot(get_absolute_time()) - boot_us) / 1000000 / 60);
+}
+
+/**
+ * @brief Returns a monotonic host clock in nanoseconds.
+ */
+static uint64_t host_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief The minute and second counters match the 64-bit division at every step, across minute ticks and
+ * at the last microsecond before each of them.
+ */
+static void test_matches_division()
+{
+	timebase_init();
+	boot_us = get_absolute_time();
+	static const uint64_t steps[] = {1, 999999, 1000000, 59000000, 999, 7, 61000000, 3600000000ull};
+	for(int pass = 0; pass < 200; pass++)
+	{
+		host_advance_us(steps[pass % count_of(steps)]);
+		if(timebase_seconds() != baseline_seconds() || timebase_minutes() != baseline_minutes())
+		{
+			TEST_EQUAL(timebase_seconds(), baseline_seconds());
+			TEST_EQUAL(timebase_minutes(), baseline_minutes());
+			break;
+		}
+		uint64_t to_tick = timebase_next_minute() - get_absolute_time();
+		TEST_CHECK(to_tick > 0 && to_tick <= TIMEBASE_MINUTE_US);
+	}
+
+	host_advance_us(timebase_next_minute() - get_absolute_time() - 1);
+	TEST_EQUAL(timebase_seconds() % 60, 59);
+	uint32_t minutes = timebase_minutes();
+	host_advance_us(1);
+	TEST_EQUAL(timebase_minutes(), minutes + 1);
+	TEST_EQUAL(timebase_seconds() % 60, 0);
+}
+
+/**
+ * @brief Times the counters against the 64-bit division they replace. Host figures only: the RP2040 has
+ * no 64-bit divide instruction, so the baseline costs it far more than it does here, see the STATE CALC
+ * line of the diagnostics screen for the device.
+ */
+static void test_benchmark()
+{
+	volatile uint32_t sink = 0;
+
+	uint64_t start = host_ns();
+	for(int i = 0; i < BENCH_CALLS; i++)
+	{
+		sink = baseline_minutes();
+	}
+	uint64_t division_ns = host_ns() - start;
+
+	start = host_ns();
+	for(int i = 0; i < BENCH_CALLS; i++)
+	{
+		sink = timebase_minutes();
+	}
+	uint64_t minutes_ns = host_ns() - start;
+
+	start = host_ns();
+	for(int i = 0; i < BENCH_CALLS; i++)
+	{
+		sink = timebase_seconds();
+	}
+	uint64_t seconds_ns = host_ns() - start;
+
+	printf("64-bit division %.2f ns, timebase_minutes() %.2f ns, timebase_seconds() %.2f ns per call\n",
+		   (double) division_ns / BENCH_CALLS, (double) minutes_ns / BENCH_CALLS, (double) seconds_ns / BENCH_CALLS);
+	(void) sink;
+}
+
+int main()
+{
+	TEST_RUN(test_matches_division);
+	TEST_RUN(test_benchmark);
+	return TEST_RESULT();
+}
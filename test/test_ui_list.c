@@ -0,0 +1,146 @@
+#include "host.h"
+#include "test.h"
+#include "ui_list.h"
+
+#define TEST_ENTRIES	1000
+#define TEST_ROWS		3
+#define TEST_ROW_HEIGHT 16
+#define TEST_ACCEL		10
+
+static int drawn_rows  = 0;	 // rows drawn by the last `ui_list_draw()`
+static int first_row   = -1; // first entry it drew
+static int last_row	   = -1; // last entry it drew
+static int rows_in_seq = 0;	 // rows that followed the previous one by one entry and one row height
+static int marker_y	   = -1; // y of the selection marker
+
+/**
+ * @brief Records the selection marker instead of drawing it.
+ */
+void ssd1306_draw_string(ssd1306_t* p, uint32_t x, uint32_t y, uint32_t scale, const char* s)
+{
+	marker_y = y;
+}
+
+/**
+ * @brief Records the drawn entries, the data source a list menu would fetch them from.
+ */
+static void draw_row(int index, int x, int y)
+{
+	if(drawn_rows == 0)
+	{
+		first_row = index;
+	} else if(index == last_row + 1 && y == (index - first_row) * TEST_ROW_HEIGHT)
+	{
+		rows_in_seq++;
+	}
+	last_row = index;
+	drawn_rows++;
+}
+
+/**
+ * @brief Draws the list and checks that exactly the visible rows around the selection were drawn.
+ */
+static void draw(ui_list_t* list, int selected)
+{
+	drawn_rows	= 0;
+	rows_in_seq = 0;
+	marker_y	= -1;
+	ui_list_draw(list, NULL, selected);
+
+	int visible = MIN(list->rows, list->count);
+	TEST_EQUAL(drawn_rows, visible);
+	TEST_EQUAL(rows_in_seq, visible - 1);
+	TEST_EQUAL(first_row, list->top);
+	TEST_CHECK(selected >= list->top && selected < list->top + visible);
+	TEST_EQUAL(marker_y, (selected - list->top) * TEST_ROW_HEIGHT);
+}
+
+/**
+ * @brief Scrolls through 1000 entries one detent at a time, down and back up. The list only scrolls when
+ * the selection would leave the visible rows, and every draw fetches the visible rows only.
+ */
+static void test_scroll_1000()
+{
+	ui_list_t list;
+	ui_list_init(&list, TEST_ROWS, TEST_ROW_HEIGHT, 1, draw_row);
+	list.count = TEST_ENTRIES;
+
+	for(int selected = 0; selected < TEST_ENTRIES; selected++)
+	{
+		draw(&list, selected);
+		TEST_EQUAL(list.top, MAX(0, selected - TEST_ROWS + 1));
+	}
+	TEST_EQUAL(list.top, TEST_ENTRIES - TEST_ROWS);
+
+	for(int selected = TEST_ENTRIES - 1; selected >= 0; selected--)
+	{
+		draw(&list, selected);
+		TEST_EQUAL(list.top, MIN(selected, TEST_ENTRIES - TEST_ROWS));
+	}
+	TEST_EQUAL(list.top, 0);
+}
+
+/**
+ * @brief Jumps to both ends and into the middle, and draws lists shorter than the screen.
+ */
+static void test_scroll_jumps()
+{
+	ui_list_t list;
+	ui_list_init(&list, TEST_ROWS, TEST_ROW_HEIGHT, 1, draw_row);
+	list.count = TEST_ENTRIES;
+
+	draw(&list, TEST_ENTRIES - 1);
+	TEST_EQUAL(list.top, TEST_ENTRIES - TEST_ROWS);
+	draw(&list, 500);
+	TEST_EQUAL(list.top, 500);
+	draw(&list, 0);
+	TEST_EQUAL(list.top, 0);
+
+	list.count = TEST_ENTRIES - 1; // entries deleted while the list was scrolled to the end
+	list.top   = TEST_ENTRIES - TEST_ROWS;
+	draw(&list, list.count - 1);
+	TEST_EQUAL(list.top, list.count - TEST_ROWS);
+
+	list.count = TEST_ROWS - 1;
+	draw(&list, 1);
+	TEST_EQUAL(list.top, 0);
+}
+
+/**
+ * @brief Detents closer together than `UI_LIST_ACCEL_MS` are multiplied by the acceleration, so the fast
+ * path crosses 1000 entries in a hundred detents.
+ */
+static void test_step_accel()
+{
+	ui_list_t list;
+	ui_list_init(&list, TEST_ROWS, TEST_ROW_HEIGHT, TEST_ACCEL, draw_row);
+	list.count = TEST_ENTRIES;
+
+	TEST_EQUAL(ui_list_step(&list, 1), 1); // first detent, nothing to compare with
+	host_time_us += UI_LIST_ACCEL_MS * 1000 - 1;
+	TEST_EQUAL(ui_list_step(&list, 1), TEST_ACCEL);
+	host_time_us += 1000;
+	TEST_EQUAL(ui_list_step(&list, -1), -TEST_ACCEL);
+	host_time_us += UI_LIST_ACCEL_MS * 1000;
+	TEST_EQUAL(ui_list_step(&list, -1), -1);
+
+	int selected = 0;
+	int detents	 = 0;
+	while(selected < TEST_ENTRIES - 1)
+	{
+		host_time_us += 10000;
+		selected	  = MIN(selected + ui_list_step(&list, 1), TEST_ENTRIES - 1);
+		draw(&list, selected);
+		detents++;
+	}
+	TEST_EQUAL(detents, (TEST_ENTRIES + TEST_ACCEL - 2) / TEST_ACCEL);
+	TEST_EQUAL(list.top, TEST_ENTRIES - TEST_ROWS);
+}
+
+int main()
+{
+	TEST_RUN(test_scroll_1000);
+	TEST_RUN(test_scroll_jumps);
+	TEST_RUN(test_step_accel);
+	return TEST_RESULT();
+}
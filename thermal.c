@@ -0,0 +1,122 @@
+#include "pico/stdlib.h"
+#include "sensors.h"
+#include "task.h"
+#include "thermal.h"
+
+static int32_t celsius10 = 0;				  // last evaluated chip temperature in 0.1 C
+static bool	   derating	 = false;			  // temperature went over the start of the curve
+static int32_t scale_q8	 = THERMAL_SCALE_ONE; // current LED scale
+static task_t  thermal_task;
+
+/**
+ * @brief Converts a raw ADC reading of the temperature sensor to 0.1 C.
+ *
+ * Integer form of the datasheet formula T = 27 - (V - 0.706) / 0.001721, with the voltage in 0.1 mV.
+ *
+ * @param raw The ADC reading (0 - 4095).
+ * @return The temperature in 0.1 C.
+ */
+int32_t thermal_raw_to_celsius10(uint16_t raw)
+{
+	int32_t v10 = ((int32_t) raw * (SENSOR_VREF_MV * 10)) >> 12;
+	return 270 - (v10 - 7060) * 1000 / 1721;
+}
+
+/**
+ * @brief Evaluates the derating curve.
+ *
+ * The scale falls linearly from 100% at `THERMAL_DERATE_START_C10` to `THERMAL_DERATE_MIN_Q8` at
+ * `THERMAL_DERATE_FULL_C10` and stays there above it. Pure function, no hardware access.
+ *
+ * @param celsius10 The temperature in 0.1 C.
+ * @param derating  true if derating is engaged; otherwise the scale is always 100%.
+ * @return The LED scale in Q8 (`THERMAL_SCALE_ONE` = 100%).
+ */
+int32_t thermal_derate_q8(int32_t celsius10, bool derating)
+{
+	if(!derating || celsius10 <= THERMAL_DERATE_START_C10)
+	{
+		return THERMAL_SCALE_ONE;
+	}
+	if(celsius10 >= THERMAL_DERATE_FULL_C10)
+	{
+		return THERMAL_DERATE_MIN_Q8;
+	}
+	return THERMAL_SCALE_ONE - (THERMAL_SCALE_ONE - THERMAL_DERATE_MIN_Q8) * (celsius10 - THERMAL_DERATE_START_C10) /
+								   (THERMAL_DERATE_FULL_C10 - THERMAL_DERATE_START_C10);
+}
+
+/**
+ * @brief Reads the filtered temperature and updates the derating state.
+ *
+ * Derating engages at `THERMAL_DERATE_START_C10` and releases `THERMAL_HYSTERESIS_C10` below it. While
+ * engaged, the scale only rises again once the temperature has fallen by the hysteresis, so the LEDs
+ * do not step up and down around a curve point.
+ */
+static void thermal_update()
+{
+	celsius10 = thermal_raw_to_celsius10(sensors_read(SENSOR_CHIP_TEMP));
+
+	if(!derating && celsius10 >= THERMAL_DERATE_START_C10)
+	{
+		derating = true;
+	} else if(derating && celsius10 < THERMAL_DERATE_START_C10 - THERMAL_HYSTERESIS_C10)
+	{
+		derating = false;
+	}
+
+	int32_t scale = thermal_derate_q8(celsius10, derating);
+	if(scale < scale_q8 || !derating || thermal_derate_q8(celsius10 + THERMAL_HYSTERESIS_C10, true) >= scale_q8)
+	{
+		scale_q8 = scale;
+	}
+}
+
+/**
+ * @brief Evaluates the temperature every `THERMAL_PERIOD_MS`.
+ */
+static task_status_t thermal_task_fn(task_t* task)
+{
+	TASK_BEGIN(task);
+	TASK_SLEEP_MS(task, SENSOR_PERIOD_MS); // let the sensor filter take its first batch
+	while(true)
+	{
+		thermal_update();
+		TASK_SLEEP_MS(task, THERMAL_PERIOD_MS);
+	}
+	TASK_END(task);
+}
+
+/**
+ * @brief Starts the thermal derating. `sensors_init()` must run first.
+ *
+ * The first evaluation happens after the first sensor filter batch.
+ */
+void thermal_init()
+{
+	task_start(&thermal_task, thermal_task_fn);
+}
+
+/**
+ * @brief Returns the last evaluated chip temperature in 0.1 C.
+ */
+int32_t thermal_celsius10()
+{
+	return celsius10;
+}
+
+/**
+ * @brief Checks whether the LED levels are currently derated.
+ */
+bool thermal_derating()
+{
+	return scale_q8 < THERMAL_SCALE_ONE;
+}
+
+/**
+ * @brief Returns the LED scale in Q8 (`THERMAL_SCALE_ONE` = 100%).
+ */
+int32_t thermal_scale_q8()
+{
+	return scale_q8;
+}
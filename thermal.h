@@ -0,0 +1,21 @@
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include "pico/stdlib.h"
+
+#define THERMAL_PERIOD_MS		 5000 // temperature evaluation period
+#define THERMAL_DERATE_START_C10 550  // derating starts at 55.0 C
+#define THERMAL_DERATE_FULL_C10	 750  // maximum derating reached at 75.0 C
+#define THERMAL_DERATE_MIN_Q8	 77	  // LED scale at maximum derating (77/256 = 30%)
+#define THERMAL_HYSTERESIS_C10	 50	  // derating ends once the temperature falls 5.0 C below the start
+
+#define THERMAL_SCALE_ONE 256 // LED scale without derating (Q8)
+
+extern void	   thermal_init();
+extern int32_t thermal_celsius10();
+extern int32_t thermal_raw_to_celsius10(uint16_t raw);
+extern int32_t thermal_derate_q8(int32_t celsius10, bool derating);
+extern bool	   thermal_derating();
+extern int32_t thermal_scale_q8();
+
+#endif // THERMAL_H
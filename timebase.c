@@ -0,0 +1,79 @@
+#include "pico/stdlib.h"
+#include "timebase.h"
+
+static repeating_timer_t		minute_timer;
+static volatile uint32_t		minutes = 0;  // whole minutes since timebase_init()
+static volatile absolute_time_t minute_start; // time of the last minute tick
+
+/**
+ * @brief Minute tick, called from the timer alarm IRQ.
+ *
+ * The timer runs at a fixed rate (negative delay), so the tick time is advanced by exactly one
+ * minute instead of being sampled, and the counters never drift.
+ */
+static bool timebase_on_minute(repeating_timer_t* rt)
+{
+	minute_start = delayed_by_us(minute_start, TIMEBASE_MINUTE_US);
+	minutes++;
+	return true; // keep repeating
+}
+
+/**
+ * @brief Starts the minute counter.
+ *
+ * The minute and second counters are maintained from a repeating hardware alarm, so the tick path
+ * never has to divide the 64-bit microsecond timer.
+ */
+void timebase_init()
+{
+	minutes		 = 0;
+	minute_start = get_absolute_time();
+	add_repeating_timer_us(-TIMEBASE_MINUTE_US, timebase_on_minute, NULL, &minute_timer);
+}
+
+/**
+ * @brief Returns the number of whole minutes since `timebase_init()`.
+ */
+uint32_t timebase_minutes()
+{
+	return minutes;
+}
+
+/**
+ * @brief Reads the minute counter together with the time of its last tick.
+ *
+ * Retries if the minute tick fires between the two reads.
+ */
+static uint32_t timebase_snapshot(absolute_time_t* start)
+{
+	uint32_t m;
+	do
+	{
+		m	   = minutes;
+		*start = minute_start;
+	} while(m != minutes);
+	return m;
+}
+
+/**
+ * @brief Returns the number of whole seconds since `timebase_init()`.
+ *
+ * Only the sub-minute part is divided, which is a 32-bit division done by the hardware divider.
+ */
+uint32_t timebase_seconds()
+{
+	absolute_time_t start;
+	uint32_t		m		   = timebase_snapshot(&start);
+	uint32_t		elapsed_us = (uint32_t) (to_us_since_boot(get_absolute_time()) - to_us_since_boot(start));
+	return m * 60 + elapsed_us / 1000000;
+}
+
+/**
+ * @brief Returns the time of the next minute tick.
+ */
+absolute_time_t timebase_next_minute()
+{
+	absolute_time_t start;
+	timebase_snapshot(&start);
+	return delayed_by_us(start, TIMEBASE_MINUTE_US);
+}
@@ -0,0 +1,13 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include "pico/stdlib.h"
+
+#define TIMEBASE_MINUTE_US 60000000 // microseconds per minute tick
+
+extern void			   timebase_init();
+extern uint32_t		   timebase_minutes();
+extern uint32_t		   timebase_seconds();
+extern absolute_time_t timebase_next_minute();
+
+#endif // TIMEBASE_H
@@ -0,0 +1,80 @@
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+#include "ui_list.h"
+
+/**
+ * @brief Initializes an empty list.
+ *
+ * @param list       The list.
+ * @param rows       Number of visible rows.
+ * @param row_height Height of a row in pixels.
+ * @param accel      Step multiplier while scrolling fast, 1 for none.
+ * @param draw_row   Draws one entry, called for the visible rows only.
+ */
+void ui_list_init(ui_list_t* list, int rows, int row_height, int accel, ui_list_row_fn_t draw_row)
+{
+	list->count		 = 0;
+	list->rows		 = rows;
+	list->row_height = row_height;
+	list->accel		 = accel;
+	list->draw_row	 = draw_row;
+	list->top		 = 0;
+	list->last_step	 = nil_time;
+}
+
+/**
+ * @brief Turns an encoder delta into a selection step.
+ *
+ * Encoder events that follow each other within `UI_LIST_ACCEL_MS` are multiplied by the list's
+ * acceleration, so long lists can be crossed quickly while single detents still move by one.
+ *
+ * @param list  The list.
+ * @param delta Encoder detents.
+ * @return The number of entries to move the selection by.
+ */
+int ui_list_step(ui_list_t* list, int delta)
+{
+	absolute_time_t now	 = get_absolute_time();
+	bool			fast = absolute_time_diff_us(list->last_step, now) < UI_LIST_ACCEL_MS * 1000;
+	list->last_step		 = now;
+	return fast ? delta * list->accel : delta;
+}
+
+/**
+ * @brief Draws the visible rows and the selection marker.
+ *
+ * The list scrolls just enough to keep the selected entry visible. Does not clear or show the display.
+ *
+ * @param list     The list.
+ * @param disp     The display.
+ * @param selected Index of the selected entry.
+ */
+void ui_list_draw(ui_list_t* list, ssd1306_t* disp, int selected)
+{
+	if(selected < list->top)
+	{
+		list->top = selected;
+	} else if(selected >= list->top + list->rows)
+	{
+		list->top = selected - list->rows + 1;
+	}
+	if(list->top > list->count - list->rows)
+	{
+		list->top = list->count - list->rows;
+	}
+	if(list->top < 0)
+	{
+		list->top = 0;
+	}
+
+	int y = 0;
+	for(int i = list->top; i < list->count && i < list->top + list->rows; i++)
+	{
+		if(i == selected)
+		{
+			ssd1306_draw_string(disp, 0, y, 2, ">"); // indicate selected entry
+		}
+		list->draw_row(i, UI_LIST_MARKER_WIDTH, y);
+		y += list->row_height;
+	}
+}
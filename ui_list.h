@@ -0,0 +1,42 @@
+#ifndef UI_LIST_H
+#define UI_LIST_H
+
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+
+#define UI_LIST_MARKER_WIDTH 11 // pixels left of the rows for the '>' selection marker
+#define UI_LIST_ACCEL_MS	 80 // encoder events closer together than this count as fast scrolling
+
+/**
+ * @brief Draws one entry of a list.
+ *
+ * @param index Index of the entry.
+ * @param x     Left edge of the row, right of the selection marker.
+ * @param y     Top edge of the row.
+ */
+typedef void (*ui_list_row_fn_t)(int index, int x, int y);
+
+/**
+ * @struct ui_list_t
+ * @brief A scrolling list that only ever touches its visible rows.
+ *
+ * The entries are not stored in the list: the row function fetches and draws an entry when it
+ * becomes visible, so the cost of scrolling and drawing does not depend on the number of entries.
+ * The selection is owned by the caller and passed in on every draw.
+ */
+typedef struct
+{
+	int				 count;		 // number of entries
+	int				 rows;		 // visible rows
+	int				 row_height; // pixels per row
+	int				 accel;		 // step multiplier while scrolling fast, 1 for none
+	ui_list_row_fn_t draw_row;	 // draws one entry
+	int				 top;		 // first visible entry
+	absolute_time_t	 last_step;	 // time of the last step, for the acceleration
+} ui_list_t;
+
+extern void ui_list_init(ui_list_t* list, int rows, int row_height, int accel, ui_list_row_fn_t draw_row);
+extern int	ui_list_step(ui_list_t* list, int delta);
+extern void ui_list_draw(ui_list_t* list, ssd1306_t* disp, int selected);
+
+#endif // UI_LIST_H